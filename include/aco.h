@@ -0,0 +1,18 @@
+#ifndef ACO_H
+#define ACO_H
+
+#include "utility.h"
+
+/**
+ * Uses the MAX-MIN ant system. The pheromone trails are stored only on the candidate list edges, so the memory
+ * is O(n*k); the other edges have the minimum trail. In each iteration the ants build their tours in parallel
+ * on the worker threads, the iteration-best tour is optionally improved with 2-opt and Or-opt moves, and then
+ * the trails are evaporated and reinforced along the iteration-best or the best-so-far tour
+ *
+ * @param inst The instance pointer of the problem
+ *
+ * @returns The status code 0 when no errors occur
+ */
+int HEU_ACO(instance *inst);
+
+#endif
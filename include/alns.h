@@ -0,0 +1,18 @@
+#ifndef ALNS_H
+#define ALNS_H
+
+#include "utility.h"
+
+/**
+ * Uses the adaptive large neighbourhood search. In each iteration a destroy operator (random, worst or spatially
+ * related removal) removes some nodes from the tour and a repair operator (cheapest or regret insertion) inserts
+ * them back. The operators are chosen with weights which adapt to their success and the new tour is accepted
+ * with the simulated annealing criterion. The best tour is polished with 2-opt and Or-opt moves at the end
+ *
+ * @param inst The instance pointer of the problem
+ *
+ * @returns The status code 0 when no errors occur
+ */
+int HEU_ALNS(instance *inst);
+
+#endif
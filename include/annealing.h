@@ -0,0 +1,17 @@
+#ifndef ANNEALING_H
+#define ANNEALING_H
+
+#include "utility.h"
+
+/**
+ * Uses the simulated annealing metaheuristic. Random 2-opt and Or-opt moves are drawn from the candidate lists
+ * and evaluated in O(1); a move is applied only when it is accepted. The temperature follows a geometric or
+ * adaptive cooling schedule which ends at the time limit, with reheats when the search stagnates
+ * 
+ * @param inst The instance pointer of the problem
+ * 
+ * @returns The status code 0 when no errors occur
+ */
+int HEU_Simulated_annealing(instance *inst);
+
+#endif
@@ -0,0 +1,48 @@
+/**
+ *  Candidate lists: for each node the list of its k nearest nodes.
+ *  The lists restrict the neighbourhoods of the heuristics to the edges that are
+ *  likely to be in a good tour, reducing the O(n^2) scans to O(n*k).
+ */
+#ifndef CANDIDATES_H
+
+#define CANDIDATES_H
+
+#include "utility.h"
+
+/**
+ * Builds the candidate lists of the instance using the spatial index in O(n*k*log n).
+ * The lists are stored in the instance and built only the first time this function is called.
+ * Call it before starting any thread which needs them.
+ * 
+ * @param inst The instance pointer of the problem
+ * @returns The candidate lists of the instance
+ */
+candidate_list* get_candidate_lists(instance *inst);
+
+/**
+ * Builds the candidate lists with k nearest nodes for each node
+ * 
+ * @param inst The instance pointer of the problem
+ * @param k The number of candidates of each node. It is reduced to num_nodes - 1 if bigger
+ * @returns The allocated candidate lists. They must be released with free_candidate_lists
+ */
+candidate_list* build_candidate_lists(instance *inst, int k);
+
+/**
+ * Releases the memory of the candidate lists
+ * 
+ * @param cand The candidate lists pointer
+ */
+void free_candidate_lists(candidate_list *cand);
+
+/**
+ * Checks whether node j is in the candidate list of node i. O(k)
+ * 
+ * @param cand The candidate lists pointer
+ * @param i The node whose list is checked
+ * @param j The node to search
+ * @returns 1 if j is a candidate of i, 0 otherwise
+ */
+int is_candidate(const candidate_list *cand, int i, int j);
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ *  Edge assembly crossover (EAX) for tours in order representation.
+ *
+ *  The edges of two parents A and B which are not shared are decomposed in AB-cycles, i.e.
+ *  cycles whose edges alternate between A and B. An offspring is built from parent A by removing
+ *  the A edges of one AB-cycle and adding its B edges. The result is a set of subtours, which are
+ *  merged with the cheapest 2-opt like exchanges between the smallest subtour and the candidate
+ *  neighbours of its nodes. The offspring inherits almost all its edges from the parents.
+ *
+ *  The removed A edges split parent A in segments, so the subtours are found on the segments and
+ *  joined with a union-find. A trial changes only the nodes of its AB-cycle and of the merges, and
+ *  its cost is the cost of parent A plus the cost changes, so it does not depend on the number of nodes.
+ */
+#ifndef EAX_H
+
+#define EAX_H
+
+#include "utility.h"
+#include "heap.h"
+
+typedef struct {
+    int num_nodes;
+    int *adj_a;         // The two neighbours of each node in parent A
+    int *adj_b;         // The two neighbours of each node in parent B
+    int *rem_a;         // The A edges of each node which are not shared with B and not used by an AB-cycle yet
+    int *deg_a;         // The number of edges of each node in rem_a
+    int *rem_b;         // The B edges of each node which are not shared with A and not used by an AB-cycle yet
+    int *deg_b;         // The number of edges of each node in rem_b
+    int *route;         // The alternating walk used to find the AB-cycles
+    int *route_pos;     // route_pos[2 * v + p] is the position of node v in the route with parity p. -1 when absent
+    int *cycles;        // The nodes of the AB-cycles one after the other. The edges in even positions of a cycle are A edges
+    int *cycle_beg;     // The nodes of cycle c are cycles[cycle_beg[c]] ... cycles[cycle_beg[c + 1] - 1]
+    int num_cycles;
+    int *cycle_order;   // The order in which the AB-cycles are tried
+    const int *order_a; // Parent A in order representation
+    int *pos_a;         // The position of each node in parent A
+    int *cuts;          // The positions in parent A of the A edges removed by the current AB-cycle, sorted. The edge at position p is (order_a[p], order_a[p + 1])
+    int num_cuts;       // The number of segments of parent A: segment t goes from position cuts[t] + 1 to cuts[t + 1]
+    int *child_adj;     // The two neighbours of each node in the offspring. It is equal to adj_a between the trials
+    int *comp;          // The union-find of the subtours on the segments: the parent of each segment. A root is a subtour
+    int *comp_size;     // The number of nodes of each subtour
+    int *comp_node;     // A node of each subtour
+    heap *subtours;     // The subtours to merge ordered by size
+    int *touched;       // The nodes whose neighbours are changed by the current trial
+    char *is_touched;
+    int num_touched;
+    int *best_nodes;    // The nodes changed by the best trial
+    int *best_adj;      // The two neighbours of the nodes changed by the best trial
+    int num_best;
+} eax_workspace;
+
+/**
+ * Allocates the memory used by the crossover
+ *
+ * @param num_nodes The number of nodes in the instance
+ * @returns The allocated workspace. It must be released with eax_free
+ */
+eax_workspace* eax_create(int num_nodes);
+
+/**
+ * Releases the memory used by the crossover
+ *
+ * @param ws The workspace pointer
+ */
+void eax_free(eax_workspace *ws);
+
+/**
+ * Generates an offspring from two parents with the single strategy of EAX: up to num_trials offsprings
+ * are generated from parent A, each one using a different random AB-cycle, and the best one is returned.
+ * When the parents are the same tour the offspring is a copy of parent A.
+ * The candidate lists of the instance must be already built.
+ * Apart from reading the parents and writing the offspring, which is done once, each trial costs as its AB-cycle
+ * and the subtours it merges.
+ *
+ * @param inst The instance pointer of the problem
+ * @param ws The workspace of the crossover
+ * @param parent_a The chromosome of parent A
+ * @param cost_a The cost of parent A
+ * @param parent_b The chromosome of parent B
+ * @param child Where the chromosome of the offspring is stored
+ * @param num_trials The number of AB-cycles tried
+ * @param rng The random generator used to build the AB-cycles
+ * @returns The cost of the offspring
+ */
+double eax_crossover(instance *inst, eax_workspace *ws, const int *parent_a, double cost_a, const int *parent_b, int *child, int num_trials, rng_state *rng);
+
+#endif
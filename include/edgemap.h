@@ -0,0 +1,76 @@
+/**
+ *  Hash table keyed by the undirected edges of the graph which stores an integer value for each edge.
+ *  It is an open addressing table with linear probing, so the memory depends only on the number of
+ *  stored edges and not on the n(n-1)/2 edges of the graph.
+ */
+#ifndef EDGEMAP_H
+
+#define EDGEMAP_H
+
+#include "utility.h"
+
+typedef struct {
+    int num_nodes;
+    long capacity;      // The number of slots. It is a power of 2
+    long count;         // The number of used slots
+    long long *keys;    // The key of the edge in each slot. -1 when the slot is empty
+    int *values;        // The value of the edge in each slot
+} edge_map;
+
+/**
+ * Allocates an empty table
+ *
+ * @param num_nodes The number of nodes of the graph
+ * @param capacity The initial number of slots. It is rounded up to a power of 2 and the table grows if needed
+ * @returns The allocated table. It must be released with edge_map_free
+ */
+edge_map* edge_map_create(int num_nodes, long capacity);
+
+/**
+ * Releases the memory of the table
+ *
+ * @param map The table pointer
+ */
+void edge_map_free(edge_map *map);
+
+/**
+ * Gives the value of the edge (i, j). O(1) expected
+ *
+ * @param map The table pointer
+ * @param i The first node of the edge
+ * @param j The second node of the edge
+ * @param value Where the value is stored when the edge is in the table
+ * @returns 1 if the edge is in the table, 0 otherwise
+ */
+int edge_map_get(const edge_map *map, int i, int j, int *value);
+
+/**
+ * Sets the value of the edge (i, j), inserting the edge if it is not in the table.
+ * The table doubles its size when it is more than half full. O(1) expected
+ *
+ * @param map The table pointer
+ * @param i The first node of the edge
+ * @param j The second node of the edge
+ * @param value The value of the edge
+ * @returns 1 if the edge was not in the table, 0 otherwise
+ */
+int edge_map_put(edge_map *map, int i, int j, int value);
+
+/**
+ * Doubles the number of slots of the table. O(capacity)
+ *
+ * @param map The table pointer
+ */
+void edge_map_grow(edge_map *map);
+
+/**
+ * Rebuilds the table with only the edges whose value is accepted by the keep function. The table doubles
+ * its size while the kept edges fill more than a quarter of it. O(capacity)
+ *
+ * @param map The table pointer
+ * @param keep Returns 1 if an edge with the given value stays in the table
+ * @param data The data passed to the keep function
+ */
+void edge_map_filter(edge_map *map, int (*keep)(int value, void *data), void *data);
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ *  Elite pool: a small set of good and different tours which the methods can feed with their local optima
+ *  and draw from to restart or to combine tours. The pool is protected by a mutex, so it can be shared by threads.
+ *
+ *  Each tour is identified by the Zobrist hash of its edge set, i.e. the XOR of a random key of each edge,
+ *  so a tour already in the pool is rejected in O(pool size) whatever its starting node and direction.
+ *  When the pool is full, a new tour replaces the most similar tour among the ones worse than it, where the
+ *  distance between two tours is the number of edges of one which are not in the other. This keeps the pool
+ *  diverse instead of filling it with small variations of the best tour.
+ *
+ *  Path relinking walks from a tour to a guiding tour with 2-opt moves, each one adding an edge of the
+ *  guiding tour, and runs the local search on some intermediate tours, which share edges of both.
+ */
+#ifndef ELITE_H
+
+#define ELITE_H
+
+#include "utility.h"
+#include "localsearch.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef struct {
+    int num_nodes;
+    int capacity;           // The maximum number of tours
+    int size;               // The number of tours in the pool
+    int *tours;             // The tours in visiting order, one after the other
+    double *costs;
+    uint64_t *hashes;       // The Zobrist hash of the edges of each tour
+    int *adj;               // Work memory: the two neighbours of each node in the offered tour
+    pthread_mutex_t mutex;  // Protects the whole pool
+} elite_pool;
+
+/**
+ * Gives the random key of the edge (i, j) used by the Zobrist hashing of the tours. The key does not depend
+ * on the direction of the edge
+ *
+ * @param i The first node of the edge
+ * @param j The second node of the edge
+ * @param num_nodes The number of nodes of the instance
+ * @returns The 64 bits key of the edge
+ */
+uint64_t edge_zobrist(int i, int j, int num_nodes);
+
+/**
+ * Computes the Zobrist hash of a tour in O(n)
+ *
+ * @param tour The tour in visiting order
+ * @param num_nodes The number of nodes of the instance
+ * @returns The XOR of the keys of the edges of the tour
+ */
+uint64_t tour_zobrist(const int *tour, int num_nodes);
+
+/**
+ * Allocates an empty elite pool
+ *
+ * @param num_nodes The number of nodes of the instance
+ * @param capacity The maximum number of tours in the pool
+ * @returns The allocated pool. It must be released with elite_free
+ */
+elite_pool* elite_create(int num_nodes, int capacity);
+
+/**
+ * Releases the memory of the pool
+ *
+ * @param pool The pool pointer
+ */
+void elite_free(elite_pool *pool);
+
+/**
+ * Offers a tour to the pool. The tour is rejected if it is already in the pool or if the pool is full
+ * and all its tours are better. Otherwise it enters the pool, replacing the most similar worse tour
+ * when the pool is full. O(pool size * n)
+ *
+ * @param pool The pool pointer
+ * @param tour The tour in visiting order
+ * @param cost The cost of the tour
+ * @returns 1 if the tour entered the pool, 0 otherwise
+ */
+int elite_add(elite_pool *pool, const int *tour, double cost);
+
+/**
+ * Copies a random tour of the pool
+ *
+ * @param pool The pool pointer
+ * @param tour Where the tour is stored in visiting order
+ * @param cost Where the cost of the tour is stored. It can be NULL
+ * @param rng The random generator used to choose the tour
+ * @returns 1 if a tour has been copied, 0 if the pool is empty
+ */
+int elite_pick(elite_pool *pool, int *tour, double *cost, rng_state *rng);
+
+/**
+ * Copies the best tour of the pool
+ *
+ * @param pool The pool pointer
+ * @param tour Where the tour is stored in visiting order. It can be NULL
+ * @returns The cost of the best tour. DBL_MAX if the pool is empty
+ */
+double elite_best(elite_pool *pool, int *tour);
+
+/**
+ * Walks from the current tour of the local search to the guiding tour. The guiding tour is followed from its
+ * first node: each step makes the next node of the guiding tour adjacent to the last one with a 2-opt move
+ * which does not break the part of the path already built. At num_checkpoints evenly spaced intermediate tours
+ * the local search is applied and then undone, so that the walk continues. At the end the local search
+ * contains the guiding tour
+ *
+ * @param ls The local search with the initial tour. Its queue is emptied
+ * @param guide The guiding tour in visiting order
+ * @param num_checkpoints The number of intermediate tours improved with the local search
+ * @param best_tour Where the best improved intermediate tour is stored in visiting order
+ * @returns The cost of the best improved intermediate tour. DBL_MAX if the two tours are too close to have one
+ */
+double path_relinking(local_search *ls, const int *guide, int num_checkpoints, int *best_tour);
+
+#endif
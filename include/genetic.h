@@ -3,6 +3,16 @@
 
 #include "utility.h"
 
+/**
+ * Uses the genetic algorithm to solve the instance problem. The population is split in islands, each one evolved
+ * by its own thread, which exchange their best individuals every MIGRATION_INTERVAL generations.
+ * The crossover is chosen at compile time with CROSSOVER_METHOD in genetic.c. By default it is the classic
+ * crossover: the edge assembly crossover (EAX) is not used unless CROSSOVER_METHOD is set to CROSSOVER_EAX
+ * 
+ * @param inst The instance pointer of the problem
+ * 
+ * @returns The status code 0 when no errors occur
+ */
 int HEU_Genetic(instance *inst);
 
 #endif
\ No newline at end of file
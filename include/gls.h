@@ -0,0 +1,18 @@
+#ifndef GLS_H
+#define GLS_H
+
+#include "utility.h"
+
+/**
+ * Uses the guided local search metaheuristic. When the 2-opt and Or-opt local search reaches a local optimum,
+ * the tour edges with the highest utility (cost / (1 + penalty)) are penalized and the local search continues
+ * from their endpoints on the costs augmented with the penalties. The penalties are stored in a hash table
+ * which contains only the penalized edges
+ *
+ * @param inst The instance pointer of the problem
+ *
+ * @returns The status code 0 when no errors occur
+ */
+int HEU_GLS(instance *inst);
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ *  Indexed binary min-heap of integer items with double keys.
+ *  The items are in [0, max_items) so the position of each item in the heap is tracked
+ *  and its key can be changed in O(log n).
+ */
+#ifndef HEAP_H
+
+#define HEAP_H
+
+#include "utility.h"
+
+typedef struct {
+    int size;       // The current number of items in the heap
+    int max_items;  // The items must be in [0, max_items)
+    int *items;     // The items in heap order
+    double *keys;   // The keys of the items in heap order
+    int *pos;       // The position of each item in the heap. -1 when the item is not in the heap
+} heap;
+
+/**
+ * Allocates an empty heap
+ * 
+ * @param max_items The items that can be stored in the heap are in [0, max_items)
+ * @returns The allocated heap. It must be released with heap_free
+ */
+heap* heap_create(int max_items);
+
+/**
+ * Releases the memory of the heap
+ * 
+ * @param h The heap pointer
+ */
+void heap_free(heap *h);
+
+/**
+ * Removes all the items from the heap. O(size)
+ * 
+ * @param h The heap pointer
+ */
+void heap_clear(heap *h);
+
+/**
+ * Inserts an item in the heap or changes its key if it is already in the heap. O(log n)
+ * 
+ * @param h The heap pointer
+ * @param item The item
+ * @param key The key of the item
+ */
+void heap_push(heap *h, int item, double key);
+
+/**
+ * Builds the heap from a list of items in O(n). The heap must be empty.
+ * 
+ * @param h The heap pointer
+ * @param items The items to insert. They must be distinct
+ * @param keys The keys of the items
+ * @param num_items The number of items
+ */
+void heap_build(heap *h, const int *items, const double *keys, int num_items);
+
+/**
+ * Removes the item with the minimum key from the heap. O(log n)
+ * 
+ * @param h The heap pointer
+ * @param key Where the key of the removed item is stored. It can be NULL
+ * @returns The removed item or -1 when the heap is empty
+ */
+int heap_pop(heap *h, double *key);
+
+/**
+ * Removes an item from the heap if present. O(log n)
+ * 
+ * @param h The heap pointer
+ * @param item The item to remove
+ */
+void heap_remove(heap *h, int item);
+
+/**
+ * Checks whether an item is in the heap
+ * 
+ * @param h The heap pointer
+ * @param item The item
+ * @returns 1 if the item is in the heap, 0 otherwise
+ */
+int heap_contains(const heap *h, int item);
+
+#endif
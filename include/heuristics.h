@@ -2,6 +2,7 @@
 #define HEURISTICS_H
 
 #include "utility.h"
+#include "kdtree.h"
 
 #define WRONG_STARTING_NODE 1
 #define TIME_LIMIT_EXCEEDED 2
@@ -23,6 +24,16 @@ int greedy(instance *inst, int starting_node);
  */
 int HEU_greedy(instance *inst);
 
+/**
+ * Computes the tour from which the metaheuristics start: the warm start tour of the instance when it is set,
+ * otherwise the nearest neighbour tour from node 0 built on the spatial index. The time limit does not
+ * stop it, so the result is always a complete tour
+ * 
+ * @param inst The instance pointer of the problem
+ * @return The error code
+ */
+int HEU_initial_tour(instance *inst);
+
 /**
  * Applies a greedy algorithm to solve the instance trying with all starting nodes possible
  * 
@@ -31,6 +42,17 @@ int HEU_greedy(instance *inst);
  */
 int HEU_Greedy_iter(instance *inst);
 
+/**
+ * Computes the extra mileage of inserting node c between the nodes a and b, i.e. C_ac + C_cb - C_ab
+ * 
+ * @param a The first node of the edge
+ * @param b The second node of the edge
+ * @param c The node to insert
+ * @param inst The instance pointer of the problem
+ * @return The cost increase of the tour
+ */
+double extra_mileage(int a, int b, int c, instance *inst);
+
 /**
  * Applies a the extra mileage algorithm to solve the instance
  * 
@@ -39,6 +61,56 @@ int HEU_Greedy_iter(instance *inst);
  */
 int HEU_extramileage(instance *inst);
 
+/**
+ * Applies the Clarke-Wright savings algorithm. The savings are computed only for the pairs of nodes
+ * which are in the candidate lists and they are processed in decreasing order using a binary heap.
+ * 
+ * @param inst The instance pointer of the problem
+ * @param hub The hub node (i.e. the depot in the vehicle routing terminology)
+ * @return The error code
+ */
+int savings(instance *inst, int hub);
+
+/**
+ * Applies the savings algorithm using as hub the node nearest to the center of the instance
+ * 
+ * @param inst The instance pointer of the problem
+ * @return The error code
+ */
+int HEU_Savings(instance *inst);
+
+/**
+ * Computes a minimum spanning tree with Prim's algorithm on the candidate graph. When the candidate graph
+ * is not connected, the components are joined with the shortest edge from the tree to the nodes outside of it,
+ * found through the spatial index, so the cost is O(n*k*log n) also when the graph has many components.
+ * The tree is the Euclidean MST only when the candidate graph contains it (which happens in practice with 8-10
+ * candidates), so its weight is an estimate and not a lower bound of the optimal tour's cost
+ * 
+ * @param inst The instance pointer of the problem
+ * @param parent Where the parent of each node in the tree is stored. The root has parent -1. It must have num_nodes entries
+ * @return The weight of the tree
+ */
+double prim_mst(instance *inst, int *parent);
+
+/**
+ * Applies a Christofides-like algorithm: minimum spanning tree, greedy matching of the odd degree nodes, 
+ * Euler tour of the resulting multigraph and shortcutting of the repeated nodes.
+ * The greedy matching replaces the minimum weight perfect matching, so the 3/2 approximation guarantee
+ * of the original algorithm is not preserved.
+ * 
+ * @param inst The instance pointer of the problem
+ * @return The error code
+ */
+int christofides(instance *inst);
+
+/**
+ * Wrapper of the Christofides-like algorithm
+ * 
+ * @param inst The instance pointer of the problem
+ * @return The error code
+ */
+int HEU_Christofides(instance *inst);
+
 /**
  * Applies the 2-opt algorithm to solve the instance
  * 
@@ -82,13 +154,16 @@ int HEU_Grasp_iter(instance *inst, int time_lim);
 int alg_2opt(instance *inst);
 
 /**
- * Applies the GRASP algorithm from a starting node
+ * Applies the GRASP algorithm from a starting node. At each step the next node is chosen from the
+ * restricted candidate list of the grasp_rcl nearest not visited nodes (see the grasp_* parameters)
  * 
  * @param inst The instance pointer of the problem
  * @param starting_node The index of the node where the algorithm starts
+ * @param tree The spatial index of the instance. It is reset by this function. Pass NULL to let grasp build its own index
+ * @param rng The random generator used for the randomized choices
  * @return The error code
  */
-int grasp(instance *inst, int starting_node);
+int grasp(instance *inst, int starting_node, kdtree *tree, rng_state *rng);
 
 /**
  * Applies the 2-opt algorithm using grasp initialization
@@ -129,4 +204,20 @@ int HEU_2opt_greedy_iter(instance *inst);
  * @return The error code
  */
 int HEU_2opt_extramileage(instance *inst);
+
+/**
+ * Applies the 2-opt algorithm using savings initialization
+ * 
+ * @param inst The instance pointer of the problem
+ * @return The error code
+ */
+int HEU_2opt_savings(instance *inst);
+
+/**
+ * Applies the 2-opt algorithm using Christofides-like initialization
+ * 
+ * @param inst The instance pointer of the problem
+ * @return The error code
+ */
+int HEU_2opt_christofides(instance *inst);
 #endif
\ No newline at end of file
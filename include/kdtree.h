@@ -0,0 +1,90 @@
+/**
+ *  Spatial index over the nodes of the instance. 
+ *
+ *  The tree is a balanced 2-d tree stored implicitly in an array: each range [lo, hi) of the array
+ *  is a subtree whose root is the median element (lo + hi) / 2. The nodes can be deactivated
+ *  (e.g. when visited by a constructive heuristic) so that the queries return only the active
+ *  ones. Each subtree keeps the count of its active nodes, so empty subtrees are skipped and
+ *  a k nearest neighbours query costs O(log n + k) on average.
+ *
+ *  The distances used to navigate the tree are the Euclidean distances between the coordinates.
+ *  The ordering is the same of the instance's costs for EUC_2D, ATT and CEIL_2D weights, while
+ *  it is an approximation for the other weight types.
+ */
+#ifndef KDTREE_H
+
+#define KDTREE_H
+
+#include "utility.h"
+
+typedef struct {
+    int num_nodes;
+    point *nodes;       // The coordinates of the instance's nodes (not owned by the tree)
+    int *perm;          // The nodes in tree order
+    int *pos;           // The position of each node in perm
+    char *dim;          // The splitting dimension of the subtree rooted in a position. 0 = x, 1 = y
+    int *count;         // The number of active nodes of the subtree rooted in a position
+    char *active;       // Whether a node is active
+} kdtree;
+
+/**
+ * Builds the spatial index of the instance's nodes. All the nodes are active.
+ * 
+ * @param inst The instance pointer of the problem
+ * @returns The allocated tree. It must be released with kdtree_free
+ */
+kdtree* kdtree_build(instance *inst);
+
+/**
+ * Releases the memory of the tree
+ * 
+ * @param tree The tree to deallocate
+ */
+void kdtree_free(kdtree *tree);
+
+/**
+ * Activates again all the nodes in O(n)
+ * 
+ * @param tree The tree pointer
+ */
+void kdtree_reset(kdtree *tree);
+
+/**
+ * Deactivates a node so it is not returned anymore by the queries. O(log n)
+ * 
+ * @param tree The tree pointer
+ * @param node The index of the node
+ */
+void kdtree_remove(kdtree *tree, int node);
+
+/**
+ * Activates again a node previously removed. O(log n)
+ * 
+ * @param tree The tree pointer
+ * @param node The index of the node
+ */
+void kdtree_insert(kdtree *tree, int node);
+
+/**
+ * Finds the k nearest active nodes to a node. The node itself is never returned.
+ * 
+ * @param tree The tree pointer
+ * @param node The index of the query node
+ * @param k The number of neighbours requested
+ * @param neighbours Where the found nodes are stored sorted by increasing distance. It must have at least k entries
+ * @param sqdist Where the squared coordinate distances of the found nodes are stored. It must have at least k entries.
+ *               It can be NULL, but then the query allocates it, so the callers which run many queries pass their own
+ * @returns The number of nodes found. It is less than k only when there are less than k active nodes
+ */
+int kdtree_knn(kdtree *tree, int node, int k, int *neighbours, double *sqdist);
+
+/**
+ * Finds the nearest active node to a node. The node itself is never returned.
+ * 
+ * @param tree The tree pointer
+ * @param node The index of the query node
+ * @returns The index of the nearest active node or -1 if there are no active nodes
+ */
+int kdtree_nearest(kdtree *tree, int node);
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ *  Local search on a tour stored as an array of nodes with the position of each node.
+ *
+ *  The neighbourhoods are 2-opt and Or-opt (segments of 1 to 3 nodes moved elsewhere, possibly reversed)
+ *  restricted to the candidate lists. The nodes to examine are kept in a FIFO queue: a node leaves the
+ *  queue when no improving move starts from it (don't look bit) and enters again when one of its edges
+ *  changes, so after a small perturbation only the affected region of the tour is searched.
+ *
+ *  Every move is a sequence of reversals of a range of positions, and the shorter side of the tour is
+ *  reversed each time. Reversals are self inverse, so they can be logged and undone, e.g. to go back
+ *  to the tour before a perturbation which did not lead to an improvement.
+ */
+#ifndef LOCALSEARCH_H
+
+#define LOCALSEARCH_H
+
+#include "utility.h"
+
+/**
+ * The cost of an edge used by the local search. It allows searching with modified costs (e.g. penalties)
+ *
+ * @param i The first node of the edge
+ * @param j The second node of the edge
+ * @param data The data given with the function
+ * @returns The cost of the edge (i, j)
+ */
+typedef double (*ls_cost_fn)(int i, int j, void *data);
+
+typedef struct {
+    instance *inst;
+    int num_nodes;
+    candidate_list *cand;   // The candidate lists which restrict the neighbourhoods
+    int *tour;              // The nodes in visiting order
+    int *pos;               // The position of each node in the tour
+    int *queue;             // Circular FIFO queue of the nodes to examine
+    int queue_head;
+    int queue_size;
+    char *in_queue;         // Whether a node is in the queue. A node not in the queue has its don't look bit set
+    int *undo_log;          // The reversals done, two positions each
+    int undo_size;          // The number of integers in the undo log
+    int undo_capacity;
+    int logging;            // Whether the reversals are logged
+    ls_cost_fn cost;        // The cost of the edges. NULL means the instance's costs
+    void *cost_data;        // The data passed to the cost function
+} local_search;
+
+/**
+ * Allocates the local search for the instance. The candidate lists of the instance are built if needed,
+ * so call it before starting the threads which use it
+ *
+ * @param inst The instance pointer of the problem
+ * @returns The allocated local search. It must be released with ls_free
+ */
+local_search* ls_create(instance *inst);
+
+/**
+ * Releases the memory of the local search
+ *
+ * @param ls The local search pointer
+ */
+void ls_free(local_search *ls);
+
+/**
+ * Changes the cost of the edges used by the local search
+ *
+ * @param ls The local search pointer
+ * @param cost The cost function. NULL means the instance's costs
+ * @param data The data passed to the cost function
+ */
+void ls_set_cost(local_search *ls, ls_cost_fn cost, void *data);
+
+/**
+ * Gives the cost of an edge used by the local search
+ *
+ * @param ls The local search pointer
+ * @param i The first node of the edge
+ * @param j The second node of the edge
+ * @returns The cost of the edge (i, j)
+ */
+double ls_edge_cost(const local_search *ls, int i, int j);
+
+/**
+ * Loads a tour. The queue and the undo log are emptied
+ *
+ * @param ls The local search pointer
+ * @param order The nodes in visiting order
+ */
+void ls_load(local_search *ls, const int *order);
+
+/**
+ * Loads a tour stored as successors, i.e. edges[i] = (i, successor of i). The queue and the undo log are emptied
+ *
+ * @param ls The local search pointer
+ * @param edges The edges of the tour
+ * @returns 0 when the successors are a tour, 1 otherwise. In that case the local search contains no valid tour
+ */
+int ls_load_edges(local_search *ls, const edge *edges);
+
+/**
+ * Stores the current tour in visiting order
+ *
+ * @param ls The local search pointer
+ * @param order Where the nodes are stored
+ */
+void ls_store(const local_search *ls, int *order);
+
+/**
+ * Stores the current tour as successors, i.e. edges[i] = (i, successor of i)
+ *
+ * @param ls The local search pointer
+ * @param edges Where the edges are stored
+ */
+void ls_store_edges(const local_search *ls, edge *edges);
+
+/**
+ * Computes the cost of the current tour in O(n)
+ *
+ * @param ls The local search pointer
+ * @returns The cost of the tour
+ */
+double ls_tour_cost(const local_search *ls);
+
+/**
+ * Gives the successor of a node in the current tour
+ */
+int ls_succ(const local_search *ls, int node);
+
+/**
+ * Gives the predecessor of a node in the current tour
+ */
+int ls_pred(const local_search *ls, int node);
+
+/**
+ * Adds a node to the queue of the nodes to examine, if not already there
+ *
+ * @param ls The local search pointer
+ * @param node The node to add
+ */
+void ls_queue_node(local_search *ls, int node);
+
+/**
+ * Adds all the nodes to the queue in tour order
+ *
+ * @param ls The local search pointer
+ */
+void ls_queue_all(local_search *ls);
+
+/**
+ * Exchanges the edges (a, b) and (c, d) with (a, c) and (b, d). The node b must follow a in the same direction
+ * in which d follows c. The endpoints are added to the queue
+ *
+ * @param ls The local search pointer
+ * @returns The cost change of the tour
+ */
+double ls_2opt_move(local_search *ls, int a, int b, int c, int d);
+
+/**
+ * Moves the segment s1 ... s2 (s1 before s2 in tour direction) between t1 and t2 = succ(t1), reversed or not.
+ * The edge (t1, t2) must be outside the segment and t2 must not be the predecessor of s1.
+ * The move is done with two or three 2-opt moves
+ *
+ * @param ls The local search pointer
+ * @param reversed Whether the segment is inserted as t1 s2 ... s1 t2 instead of t1 s1 ... s2 t2
+ * @returns The cost change of the tour
+ */
+double ls_move_segment(local_search *ls, int s1, int s2, int t1, int t2, int reversed);
+
+/**
+ * Applies improving 2-opt and Or-opt moves starting from the nodes in the queue until the queue is empty
+ *
+ * @param ls The local search pointer
+ * @returns The cost change of the tour (negative or zero)
+ */
+double ls_optimize(local_search *ls);
+
+/**
+ * Starts logging the reversals and gives the current point of the log
+ *
+ * @param ls The local search pointer
+ * @returns The mark to pass to ls_undo to go back to the current tour
+ */
+int ls_mark(local_search *ls);
+
+/**
+ * Undoes all the reversals done after the mark and stops logging
+ *
+ * @param ls The local search pointer
+ * @param mark The mark given by ls_mark
+ */
+void ls_undo(local_search *ls, int mark);
+
+/**
+ * Forgets the logged reversals and stops logging
+ *
+ * @param ls The local search pointer
+ */
+void ls_commit(local_search *ls);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "utility.h"
+
+/**
+ * Races a portfolio of heuristics on a thread pool. The methods are given with -portfolio as a comma separated
+ * list of the names accepted by -method. Each method runs in time slices on its own scratch instance, which shares
+ * the read-only data of the problem (nodes, candidate lists) and owns its tour. Every slice starts from the shared
+ * incumbent when it is better than the best tour of the method, so a method that falls behind restarts from the
+ * work of the others. The incumbent cost is read without locking. The run stops at the time limit or as soon as
+ * a tour with cost at most -target is found. Statistics of each method are printed at the end
+ *
+ * @param inst The instance pointer of the problem
+ * @param solve The function which runs the method of an instance, i.e. the dispatcher of the heuristics
+ *
+ * @returns The status code 0 when no errors occur
+ */
+int HEU_Portfolio(instance *inst, int (*solve)(instance *));
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ *  Pseudo random number generation.
+ *
+ *  Every randomized routine receives an explicit generator state instead of relying on
+ *  the global random()/rand() of libc, which is shared between threads and serialized
+ *  by a lock. A state is derived from the user's seed and a stream id, so each thread
+ *  (or each independent run) draws from its own non overlapping sequence and the results
+ *  are reproducible for a given seed.
+ */
+#ifndef RANDOM_H
+
+#define RANDOM_H
+
+#include <stdint.h>
+
+// State of a xoshiro256** generator. Check here for details: https://prng.di.unimi.it
+typedef struct {
+    uint64_t s[4];
+} rng_state;
+
+/**
+ * Initializes a generator from a seed and a stream id. Different streams with the same seed
+ * produce non overlapping sequences (each stream is 2^128 numbers apart from the previous one).
+ *
+ * @param rng The generator state to initialize
+ * @param seed The seed of the generator (e.g. the -seed parameter)
+ * @param stream The stream id (e.g. the thread id)
+ */
+void rng_seed(rng_state *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * Generates the next 64 bit random number
+ *
+ * @param rng The generator state
+ * @returns A random 64 bit unsigned integer
+ */
+uint64_t rng_next(rng_state *rng);
+
+/**
+ * Generates a random double uniformly distributed in [0, 1)
+ *
+ * @param rng The generator state
+ * @returns A random double in [0, 1)
+ */
+double rng_urand(rng_state *rng);
+
+#endif
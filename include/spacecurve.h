@@ -0,0 +1,41 @@
+/**
+ *  Renumbering of the nodes along a space-filling curve.
+ *  Nodes which are near in the plane get near indices, so the arrays indexed by node
+ *  (coordinates, tour edges, candidate lists, flags) are accessed with good memory locality.
+ */
+#ifndef SPACECURVE_H
+
+#define SPACECURVE_H
+
+#include "utility.h"
+
+/**
+ * Computes the index of a cell along the Hilbert curve which covers a 2^order x 2^order grid
+ * 
+ * @param x The column of the cell
+ * @param y The row of the cell
+ * @param order The number of bits of each coordinate. At most 31
+ * @returns The position of the cell along the curve
+ */
+uint64_t hilbert_index(uint32_t x, uint32_t y, int order);
+
+/**
+ * Sorts the nodes of the instance along the Hilbert curve in O(n log n).
+ * The original index of each node is stored in inst->original_ids so that the output 
+ * (exported tour and printed solution) uses the indices of the TSPLIB file.
+ * It must be called before any data structure indexed by node is built.
+ * 
+ * @param inst The instance pointer of the problem
+ */
+void renumber_nodes(instance *inst);
+
+/**
+ * Gives the index of the node in the TSPLIB file
+ * 
+ * @param inst The instance pointer of the problem
+ * @param node The internal index of the node
+ * @returns The original index of the node (0 based)
+ */
+int original_id(const instance *inst, int node);
+
+#endif
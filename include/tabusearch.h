@@ -4,24 +4,36 @@
 #include "utility.h"
 
 /**
- * Uses the tabu search metaheuristic using a step tenure policy
+ * Uses the tabu search metaheuristic using a step tenure policy.
+ * A trajectory runs on each thread and the trajectories share an elite pool of tours
  * 
  * @param inst The instance of the problem
  */
 int HEU_Tabu_step(instance *inst);
 
 /**
- * Uses the tabu search metaheuristic using a linear change tenure policy from min_tenure to max_tenure and viceversa
+ * Uses the tabu search metaheuristic using a linear change tenure policy from min_tenure to max_tenure and viceversa.
+ * A trajectory runs on each thread and the trajectories share an elite pool of tours
  * 
  * @param inst The instance of the problem
  */
 int HEU_Tabu_lin(instance *inst);
 
 /**
- * Uses the tabu search metaheuristic using a random tenure policy
+ * Uses the tabu search metaheuristic using a random tenure policy.
+ * A trajectory runs on each thread and the trajectories share an elite pool of tours
  * 
  * @param inst The instance of the problem
  */
 int HEU_Tabu_rand(instance *inst);
 
+/**
+ * Uses the tabu search metaheuristic using a reactive tenure policy: the tenure increases when a local optimum
+ * is visited again and decreases when no local optimum is repeated for a while.
+ * A trajectory runs on each thread and the trajectories share an elite pool of tours
+ * 
+ * @param inst The instance of the problem
+ */
+int HEU_Tabu_reactive(instance *inst);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+/**
+ * Implementation of tour merging heuristic
+ */
+#ifndef TOURMERGE_H
+#define TOURMERGE_H
+
+#include <cplex.h>
+#include "utility.h"
+
+#define TOUR_MERGE_NUM_TOURS 10 // The number of VNS runs. Their different tours are merged
+#define TOUR_MERGE_HEURISTIC_TIME_RATE 0.5 // The part of the time limit given to the VNS runs
+
+/**
+ * Function which uses the tour merging solver. Some VNS runs with different seeds collect good tours.
+ * The model contains only the edges of these tours (usually about 1.5 edges per node instead of n(n-1)/2)
+ * and it is solved with the SEC callbacks, so the solution is the best tour which uses only their edges.
+ * The columns are described by inst->sparse
+ *
+ * @param inst The instance pointer of the problem
+ * @param env The cplex's environment
+ * @param lp The cplex's problem object. It is empty: the solver builds the model
+ * @return The error code
+ **/
+int tour_merge_solver(instance *inst, CPXENVptr env, CPXLPptr lp);
+
+#endif
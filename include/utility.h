@@ -9,6 +9,8 @@
 #include <sys/time.h>
 #include <string.h>
 
+#include "random.h"
+
 #define MALLOC(nnum,type) ( (type *) malloc (nnum * sizeof(type)) )
 #define CALLOC(nnum,type) ( (type *) calloc (nnum, sizeof(type)) )
 #define REALLOC(ptr, nnum, type) ( realloc(ptr, nnum * sizeof(type)) )
@@ -33,12 +35,17 @@
 #define LOG_E(fmt, ...) {fprintf(stderr, "[ERROR] ");fprintf(stderr, fmt, ## __VA_ARGS__);fprintf(stderr, "\n");fflush(NULL);exit(1);}
 #define FREE(ptr) free(ptr); ptr=NULL;
 #define LEN(arr) (sizeof(arr) / sizeof(*arr))
-#define URAND() ( ((double) random()) / RAND_MAX )
+#define URAND(rng) ( rng_urand(rng) )
 
 
 // Constant that is useful for numerical errors
 #define EPS 1e-5
 #define DEFAULT_TIME_LIM 900 // 15 minutes
+#define DEFAULT_GRASP_RAND 0.9 // Probability of choosing the nearest node in GRASP
+#define DEFAULT_GRASP_RCL 2 // Size of the GRASP's restricted candidate list. With 2 GRASP choses between the nearest and the 2nd nearest node
+#define DEFAULT_GRASP_ITER_TIME_LIM 120 // 2 minutes
+#define DEFAULT_NUM_CANDIDATES 10 // The number of nearest nodes stored in the candidate list of each node
+#define DEFAULT_SYNC_ROUNDS 50 // The number of synchronization rounds of parallel VNS in deterministic mode
 
 
 // ================ Weight types =====================
@@ -76,11 +83,22 @@ typedef enum {
     SOLVE_2OPT_GREEDY,          // Uses 2opt algorithm with greedy initialization
     SOLVE_2OPT_GREEDY_ITER,     // Uses 2opt algorithm with iterative greedy initialization
     SOLVE_2OPT_EXTR_MIL,        // Uses 2opt algorithm with extra mileage initialization
+    SOLVE_SAVINGS,              // Uses the Clarke-Wright savings heuristic
+    SOLVE_2OPT_SAVINGS,         // Uses 2opt algorithm with savings initialization
+    SOLVE_CHRISTOFIDES,         // Uses the Christofides-like heuristic
+    SOLVE_2OPT_CHRISTOFIDES,    // Uses 2opt algorithm with Christofides-like initialization
     SOLVE_VNS,                  // Uses the VNS local search algorithm
     SOLVE_TABU_STEP,            // Uses the Tabu search algorithm with step policy
     SOLVE_TABU_LIN,             // Uses the Tabu search algorithm with linear policy
     SOLVE_TABU_RAND,            // Uses the Tabu search algorithm with random policy
-    SOLVE_GENETIC               // Uses the Genetic algorithm
+    SOLVE_TABU_REACTIVE,        // Uses the Tabu search algorithm with reactive policy
+    SOLVE_GENETIC,              // Uses the Genetic algorithm
+    SOLVE_SIMULATED_ANNEALING,  // Uses the Simulated annealing algorithm
+    SOLVE_ACO,                  // Uses the MAX-MIN ant system
+    SOLVE_ALNS,                 // Uses the Adaptive large neighbourhood search
+    SOLVE_GLS,                  // Uses the Guided local search
+    SOLVE_PORTFOLIO,            // Races several heuristics on a thread pool
+    SOLVE_TOUR_MERGE            // Solves with cplex the model restricted to the edges of some heuristic tours
 } solver_type;
 
 
@@ -120,6 +138,16 @@ typedef struct {
     int seed;           // Seed for random generation
     int perf_prof;      // Need to know wheter the computation is executed for performance profile
     int callback_2opt;  // Used in incubement callbacks for 2opt refinement
+    double grasp_rand;  // Probability of choosing the nearest node in GRASP
+    int grasp_rcl;      // The size of the GRASP's restricted candidate list (i.e. the k nearest not visited nodes)
+    double grasp_alpha; // When >= 0 GRASP choses uniformly among the candidates whose cost is within d_min + alpha * (d_max - d_min)
+    int grasp_time_lim; // Time limit of iterated GRASP when the time limit is not given
+    int num_candidates; // The size of the candidate list of each node
+    int renumber;       // 1=the nodes are renumbered along a space-filling curve before solving with heuristics, 0=file order
+    int deterministic;  // 1=the parallel heuristics exchange solutions only at fixed synchronization points, so runs are reproducible
+    int sync_rounds;    // The number of synchronization rounds after which the deterministic mode stops. It replaces the time limit
+    char* portfolio;    // The comma separated methods raced by the portfolio method. NULL means the default mix
+    double target_obj;  // The portfolio method stops when it finds a tour with this cost or lower. A negative value means no target
 } instance_params;
 
 // Definition of Point
@@ -136,6 +164,22 @@ typedef struct {
     int j; // Index of node j
 } edge;
 
+// Candidate lists: the k nearest nodes of each node. Check candidates.h
+typedef struct {
+    int num_nodes;
+    int k;                  // The number of candidates of each node
+    int *neighbours;        // neighbours[i * k + c] is the c-th nearest node of node i
+} candidate_list;
+
+// Sparse graph: the edges of a model which contains only some edges. Check tourmerge.h
+typedef struct {
+    int num_edges;
+    edge *edges;            // edges[c] is the edge of column c
+    int *beg;               // The neighbours of node i are adj[beg[i]] ... adj[beg[i + 1] - 1]
+    int *adj;
+    int *cols;              // cols[p] is the column of the edge (i, adj[p])
+} sparse_graph;
+
 typedef struct {
 double obj_best;            // Stores the best value of the objective function
     edge *edges;            // List the solution's edges: list of pairs (i,j)
@@ -154,7 +198,12 @@ typedef struct {
     weight_type weight_type;
     long num_columns;           // The number of variables. It is used in callback method
     int* ind;                   // List of the indices of solution values in cplex. Needed for updating manually the incubement in cplex. Used in callbacks
-    unsigned int* thread_seeds; // An array which contains the seed for each thread. Used in relaxation callback to create a randomness
+    rng_state rng;              // The random generator of the main thread. It is seeded with the -seed parameter
+    rng_state* thread_rngs;     // An array which contains a random generator stream for each thread. Used in relaxation callback to create a randomness
+    candidate_list* candidates; // The candidate lists of the nodes. They are built on demand by get_candidate_lists
+    int* original_ids;          // original_ids[i] is the index in the input file of node i. NULL when the nodes are not renumbered
+    const int* warm_start;      // A tour in visiting order from which the metaheuristics start instead of the greedy tour. NULL by default
+    sparse_graph* sparse;       // The edges of the columns when the model does not contain all the edges. NULL for the complete model
 
     solution solution;
 } instance;
@@ -184,6 +233,17 @@ double dmax(double d1, double d2);
  */
 int x_udir_pos(int i, int j, int num_nodes);
 
+/**
+ * Gives the column of the undirected edge (i, j) in the model of the instance. It is x_udir_pos for
+ * the complete model, while the sparse model of inst->sparse may not contain the edge
+ *
+ * @param inst The instance pointer of the problem
+ * @param i The index of node i
+ * @param j The index of node j
+ * @returns The column of the edge. -1 if the edge is not in the model
+ */
+int x_udir_col(const instance *inst, int i, int j);
+
 
 /**
  * Transforms the indexes (i, j) to a scalar index k for
@@ -208,6 +268,15 @@ int x_dir_pos(int i, int j, int num_nodes);
  */ 
 void parse_comand_line(int argc, const char *argv[], instance *inst);
 
+/**
+ * Finds the method with the given name, i.e. a name accepted by -method
+ *
+ * @param method The name of the method
+ * @param params The parameters where the method is stored when found. The callback variants with 2opt set also callback_2opt
+ * @returns 1 if the method has been found, 0 otherwise
+ */
+int parse_method(const char *method, instance_params *params);
+
 /**
  * Deallocates an instance from memory
  *
@@ -344,14 +413,31 @@ void reverse_path(instance *inst, int start_node, int end_node, int *prev);
  */
 void copy_instance(instance *dst, instance *src);
 
+/**
+ * Releases the memory of a sparse graph
+ *
+ * @param graph The sparse graph pointer
+ */
+void free_sparse_graph(sparse_graph *graph);
+
 
 /**
  * Choses a random number in between [from, to)
  * 
  * @param from The left bound 
  * @param to The right bound
+ * @param rng The random generator used to draw the number
  * @returns Random integer between [from, to)
  */
-int rand_choice(int from, int to);
+int rand_choice(int from, int to, rng_state *rng);
+
+/**
+ * Gives the number of threads the heuristic methods should use.
+ * It is the -threads parameter when given, otherwise the number of available processors
+ * 
+ * @param inst The instance pointer of the problem
+ * @returns The number of threads
+ */
+int get_num_threads(const instance *inst);
 
 #endif
\ No newline at end of file
@@ -4,7 +4,8 @@
 #include "utility.h"
 
 /**
- * Uses the VNS metaheuristic algorithm to solve the instance problem
+ * Uses the VNS metaheuristic algorithm to solve the instance problem.
+ * Each thread runs its own search and every SYNC_INTERVAL iterations it exchanges its tour with the incumbent
  * 
  * @param inst The instance pointer of the problem
  * 
@@ -0,0 +1,362 @@
+#include "aco.h"
+
+#include "heuristics.h"
+#include "distutil.h"
+#include "candidates.h"
+#include "kdtree.h"
+#include "localsearch.h"
+
+#include <pthread.h>
+
+////////////////////////////////////////////////////////
+///////////////// HYPERPARAMETERS //////////////////////
+////////////////////////////////////////////////////////
+#define NUM_ANTS 25 // The number of tours built in each iteration. The ants are split among the threads
+#define ALPHA 1.0 // The exponent of the pheromone trail in the choice of the next node
+#define BETA 2.0 // The exponent of the inverse of the distance in the choice of the next node
+#define EVAPORATION 0.2 // The fraction of the pheromone which evaporates in each iteration
+#define P_BEST 0.05 // The probability of building the best tour when the trails are at their limits. It sets the ratio between the minimum and the maximum trail
+#define LOCAL_SEARCH 1 // Whether the iteration-best tour is improved with 2-opt and Or-opt moves before updating the trails
+#define GLOBAL_UPDATE_INTERVAL 10 // Every this number of iterations the trails are reinforced along the best-so-far tour instead of the iteration-best one
+#define REINIT_ITERATIONS 200 // The number of iterations without improving the best tour after which the trails are reset to the maximum
+
+// Data shared by the threads of the colony
+typedef struct {
+    instance *inst;
+    double time_limit;
+    struct timeval start;
+    int num_threads;
+    pthread_mutex_t mutex;      // Protects the barrier
+    pthread_cond_t cond;
+    int waiting;                // The number of threads waiting at the barrier
+    int generation;             // The number of times the barrier has been passed
+    candidate_list *cand;
+    double *trail;              // trail[i * k + h] is the pheromone on the edge between node i and its h-th candidate
+    double *heuristic;          // The inverse of the distance of the candidate edges raised to BETA
+    double *choice;             // The weight of the candidate edges in the choice of the next node
+    double trail_min;
+    double trail_max;
+    int *tours;                 // The tours built by the ants in the current iteration, num_nodes nodes each
+    double *costs;              // The cost of the tours of the current iteration
+    local_search *ls;           // Improves the iteration-best tour. It is used only by the main thread
+    int *best_tour;             // The best tour found, in visiting order
+    double best_obj;
+    int iterations;
+    int last_improvement;       // The iteration of the last improvement of the best tour
+    int reinits;                // The number of times the trails were reset
+    int stop;                   // Whether the threads stop after the current iteration
+} aco_shared;
+
+// A thread building the tours of a part of the ants
+typedef struct {
+    aco_shared *shared;
+    int id;
+    rng_state rng;              // The random stream of the thread
+    kdtree *tree;               // The unvisited nodes. Used when all the candidates of a node are visited
+    unsigned int *visited;      // A node is visited in the current tour when its entry is equal to the stamp
+    unsigned int stamp;
+} aco_thread;
+
+/**
+ * Waits until all the threads reach the barrier
+ */
+static void barrier_wait(aco_shared *shared) {
+    pthread_mutex_lock(&(shared->mutex));
+    int generation = shared->generation;
+    if (++(shared->waiting) == shared->num_threads) {
+        shared->waiting = 0;
+        shared->generation++;
+        pthread_cond_broadcast(&(shared->cond));
+    } else {
+        while (generation == shared->generation) {
+            pthread_cond_wait(&(shared->cond), &(shared->mutex));
+        }
+    }
+    pthread_mutex_unlock(&(shared->mutex));
+}
+
+/**
+ * Builds the tour of an ant from a random node. The next node is drawn among the unvisited candidates of the
+ * current node with probability proportional to their weight. When all the candidates are visited the ant moves
+ * to the nearest unvisited node, which is the best choice among the edges with the minimum trail
+ *
+ * @param ant The thread which builds the tour
+ * @param tour Where the tour is stored
+ * @returns The cost of the tour
+ */
+static double construct_tour(aco_thread *ant, int *tour) {
+    aco_shared *shared = ant->shared;
+    instance *inst = shared->inst;
+    int n = inst->num_nodes;
+    int k = shared->cand->k;
+    unsigned int *visited = ant->visited;
+    if (++(ant->stamp) == 0) {
+        memset(visited, 0, n * sizeof(unsigned int));
+        ant->stamp = 1;
+    }
+    unsigned int stamp = ant->stamp;
+    kdtree_reset(ant->tree);
+
+    int curr = rand_choice(0, n, &(ant->rng));
+    tour[0] = curr;
+    visited[curr] = stamp;
+    kdtree_remove(ant->tree, curr);
+    double cost = 0;
+    for (int pos = 1; pos < n; pos++) {
+        const int *neighbours = &(shared->cand->neighbours[(long) curr * k]);
+        const double *choice = &(shared->choice[(long) curr * k]);
+        double total = 0;
+        for (int h = 0; h < k; h++) {
+            if (visited[neighbours[h]] != stamp) { total += choice[h]; }
+        }
+        int next = -1;
+        if (total > 0) {
+            double r = URAND(&(ant->rng)) * total;
+            for (int h = 0; h < k; h++) {
+                if (visited[neighbours[h]] == stamp) continue;
+                next = neighbours[h]; // The last unvisited candidate is taken if r is not consumed due to rounding
+                r -= choice[h];
+                if (r < 0) break;
+            }
+        } else {
+            next = kdtree_nearest(ant->tree, curr);
+        }
+        tour[pos] = next;
+        visited[next] = stamp;
+        kdtree_remove(ant->tree, next);
+        cost += calc_dist(curr, next, inst);
+        curr = next;
+    }
+    return cost + calc_dist(curr, tour[0], inst);
+}
+
+/**
+ * Sets the limits of the trails from the cost of the best tour
+ */
+static void set_trail_limits(aco_shared *shared) {
+    int n = shared->inst->num_nodes;
+    double avg = shared->cand->k > 2 ? shared->cand->k / 2.0 : 2.0; // The average number of choices of an ant
+    double p_dec = pow(P_BEST, 1.0 / n);
+    shared->trail_max = 1.0 / (EVAPORATION * shared->best_obj);
+    shared->trail_min = shared->trail_max * (1 - p_dec) / ((avg - 1) * p_dec);
+    if (shared->trail_min > shared->trail_max) { shared->trail_min = shared->trail_max; }
+}
+
+/**
+ * Adds pheromone on the edge (i, j) if j is a candidate of i
+ */
+static void add_trail(aco_shared *shared, int i, int j, double amount) {
+    int k = shared->cand->k;
+    const int *neighbours = &(shared->cand->neighbours[(long) i * k]);
+    for (int h = 0; h < k; h++) {
+        if (neighbours[h] == j) {
+            shared->trail[(long) i * k + h] += amount;
+            return;
+        }
+    }
+}
+
+/**
+ * Evaporates the trails, reinforces the edges of a tour and updates the weights used by the ants. The edges
+ * are stored in the lists of both their endpoints, so both copies are updated
+ *
+ * @param shared The data of the colony
+ * @param tour The tour which deposits the pheromone, in visiting order
+ * @param cost The cost of the tour
+ */
+static void update_trails(aco_shared *shared, const int *tour, double cost) {
+    int n = shared->inst->num_nodes;
+    long size = (long) n * shared->cand->k;
+    for (long e = 0; e < size; e++) { shared->trail[e] *= 1 - EVAPORATION; }
+    for (int pos = 0; pos < n; pos++) {
+        int i = tour[pos];
+        int j = tour[(pos + 1) % n];
+        add_trail(shared, i, j, 1.0 / cost);
+        add_trail(shared, j, i, 1.0 / cost);
+    }
+    for (long e = 0; e < size; e++) {
+        if (shared->trail[e] < shared->trail_min) { shared->trail[e] = shared->trail_min; }
+        else if (shared->trail[e] > shared->trail_max) { shared->trail[e] = shared->trail_max; }
+        shared->choice[e] = pow(shared->trail[e], ALPHA) * shared->heuristic[e];
+    }
+}
+
+/**
+ * Resets all the trails to the maximum
+ */
+static void reset_trails(aco_shared *shared) {
+    long size = (long) shared->inst->num_nodes * shared->cand->k;
+    for (long e = 0; e < size; e++) {
+        shared->trail[e] = shared->trail_max;
+        shared->choice[e] = pow(shared->trail[e], ALPHA) * shared->heuristic[e];
+    }
+}
+
+/**
+ * Ends an iteration: improves the iteration-best tour, updates the best tour and the trails and checks the time.
+ * It runs on the main thread while the other threads wait at the barrier
+ */
+static void end_iteration(aco_shared *shared) {
+    instance *inst = shared->inst;
+    int n = inst->num_nodes;
+    shared->iterations++;
+
+    int winner = 0;
+    for (int a = 1; a < NUM_ANTS; a++) {
+        if (shared->costs[a] < shared->costs[winner]) { winner = a; }
+    }
+    local_search *ls = shared->ls;
+    ls_load(ls, &(shared->tours[(long) winner * n]));
+    double cost = shared->costs[winner];
+    if (LOCAL_SEARCH) {
+        ls_queue_all(ls);
+        cost += ls_optimize(ls);
+    }
+
+    if (cost < shared->best_obj - EPS) {
+        shared->best_obj = cost;
+        ls_store(ls, shared->best_tour);
+        shared->last_improvement = shared->iterations;
+        set_trail_limits(shared);
+        if (inst->params.verbose >= 3) {LOG_I("Iteration %d. Updated incumbent: %0.0f", shared->iterations, cost);}
+    }
+    if (inst->params.verbose >= 4) {LOG_I("Iteration %d: iteration best %0.0f, best %0.0f", shared->iterations, cost, shared->best_obj);}
+
+    if (shared->iterations - shared->last_improvement >= REINIT_ITERATIONS) {
+        reset_trails(shared);
+        shared->last_improvement = shared->iterations;
+        shared->reinits++;
+        if (inst->params.verbose >= 4) {LOG_I("Trails reset");}
+    } else if (shared->iterations % GLOBAL_UPDATE_INTERVAL == 0) {
+        update_trails(shared, shared->best_tour, shared->best_obj);
+    } else {
+        update_trails(shared, ls->tour, cost);
+    }
+
+    //Check elapsed time
+    struct timeval end;
+    gettimeofday(&end, 0);
+    shared->stop = get_elapsed_time(shared->start, end) > shared->time_limit;
+}
+
+/**
+ * The loop of a thread: in each iteration it builds the tours of the ants id, id + num_threads, ...
+ * and waits for the trails update
+ *
+ * @param arg The aco_thread pointer
+ */
+static void* run_ants(void *arg) {
+    aco_thread *thread = (aco_thread*) arg;
+    aco_shared *shared = thread->shared;
+    int n = shared->inst->num_nodes;
+    while (1) {
+        for (int a = thread->id; a < NUM_ANTS; a += shared->num_threads) {
+            shared->costs[a] = construct_tour(thread, &(shared->tours[(long) a * n]));
+        }
+        barrier_wait(shared);
+        if (thread->id == 0) { end_iteration(shared); }
+        barrier_wait(shared);
+        if (shared->stop) break;
+    }
+    return NULL;
+}
+
+int HEU_ACO(instance *inst) {
+    aco_shared shared;
+    shared.inst = inst;
+    int n = inst->num_nodes;
+
+    //Set time limit
+    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);}
+    shared.time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+
+    //Start counting time from now
+    gettimeofday(&(shared.start), 0);
+
+    //The initial tour (nearest neighbour or warm start) is the first incumbent and sets the initial trails
+    int status = HEU_initial_tour(inst);
+    if (status) {LOG_E("An error occurred in HEU_initial_tour");}
+    shared.cand = get_candidate_lists(inst);
+    shared.ls = ls_create(inst);
+    if (ls_load_edges(shared.ls, inst->solution.edges)) {LOG_E("The initial solution is not a tour");}
+    shared.best_tour = MALLOC(n, int);
+    ls_store(shared.ls, shared.best_tour);
+    shared.best_obj = ls_tour_cost(shared.ls);
+    if (inst->params.verbose >= 3) {LOG_I("Initial solution: %0.0f", shared.best_obj);}
+
+    int k = shared.cand->k;
+    long size = (long) n * k;
+    shared.trail = MALLOC(size, double);
+    shared.heuristic = MALLOC(size, double);
+    shared.choice = MALLOC(size, double);
+    for (int i = 0; i < n; i++) {
+        for (int h = 0; h < k; h++) {
+            double dist = calc_dist(i, shared.cand->neighbours[(long) i * k + h], inst);
+            shared.heuristic[(long) i * k + h] = pow(1.0 / (dist > EPS ? dist : EPS), BETA);
+        }
+    }
+    set_trail_limits(&shared);
+    reset_trails(&shared);
+    shared.tours = MALLOC(((long) NUM_ANTS * n), int);
+    shared.costs = MALLOC(NUM_ANTS, double);
+    shared.iterations = 0;
+    shared.last_improvement = 0;
+    shared.reinits = 0;
+    shared.stop = 0;
+
+    //The ants are split among the threads
+    int num_threads = get_num_threads(inst);
+    if (num_threads > NUM_ANTS) { num_threads = NUM_ANTS; }
+    if (num_threads < 1) { num_threads = 1; }
+    shared.num_threads = num_threads;
+    shared.waiting = 0;
+    shared.generation = 0;
+    pthread_mutex_init(&(shared.mutex), NULL);
+    pthread_cond_init(&(shared.cond), NULL);
+    if (inst->params.verbose >= 3) {LOG_I("Ant colony with %d ants on %d threads", NUM_ANTS, num_threads);}
+
+    aco_thread *threads = CALLOC(num_threads, aco_thread);
+    pthread_t *handles = MALLOC(num_threads, pthread_t);
+    for (int i = 0; i < num_threads; i++) {
+        threads[i].shared = &shared;
+        threads[i].id = i;
+        rng_seed(&(threads[i].rng), inst->params.seed, i + 1); // Stream 0 is used by the main thread
+        threads[i].tree = kdtree_build(inst);
+        threads[i].visited = CALLOC(n, unsigned int);
+        threads[i].stamp = 0;
+    }
+    for (int i = 1; i < num_threads; i++) {
+        pthread_create(&(handles[i]), NULL, run_ants, &(threads[i]));
+    }
+    run_ants(&(threads[0])); // The main thread builds the tours of the first ants and updates the trails
+    for (int i = 1; i < num_threads; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    status = TIME_LIMIT_EXCEEDED;
+
+    if (inst->params.verbose >= 3) {
+        LOG_I("Ant colony: %d iterations, %d trail resets", shared.iterations, shared.reinits);
+    }
+
+    ls_load(shared.ls, shared.best_tour);
+    ls_store_edges(shared.ls, inst->solution.edges);
+    inst->solution.obj_best = shared.best_obj;
+
+    // Free allocations
+    for (int i = 0; i < num_threads; i++) {
+        kdtree_free(threads[i].tree);
+        FREE(threads[i].visited);
+    }
+    FREE(threads);
+    FREE(handles);
+    pthread_mutex_destroy(&(shared.mutex));
+    pthread_cond_destroy(&(shared.cond));
+    FREE(shared.trail);
+    FREE(shared.heuristic);
+    FREE(shared.choice);
+    FREE(shared.tours);
+    FREE(shared.costs);
+    FREE(shared.best_tour);
+    ls_free(shared.ls);
+    return status;
+}
@@ -0,0 +1,479 @@
+#include "alns.h"
+
+#include "heuristics.h"
+#include "distutil.h"
+#include "kdtree.h"
+#include "localsearch.h"
+
+#include <float.h>
+
+////////////////////////////////////////////////////////
+///////////////// HYPERPARAMETERS //////////////////////
+////////////////////////////////////////////////////////
+#define MIN_REMOVED 4 // The minimum number of nodes removed by a destroy operator
+#define MAX_REMOVED 60 // The maximum number of nodes removed by a destroy operator
+#define MAX_REMOVED_RATE 10 // The maximum number of removed nodes in percentage with the number of nodes, when it is lower than MAX_REMOVED
+#define WORST_SAMPLE 8 // Worst removal removes the node with the highest removal gain among this number of random nodes
+#define INSERT_NEIGHBOURS 6 // The insertion positions of a node are the edges of its nearest nodes in the tour
+#define SEGMENT_LENGTH 100 // The number of iterations after which the weights of the operators are updated
+#define REACTION_FACTOR 0.1 // How fast the weights follow the scores of the last segment
+#define MIN_WEIGHT 0.05 // The minimum weight of an operator, so that every operator keeps being tried
+#define SCORE_BEST 33 // The score of an operator which finds a new best tour
+#define SCORE_BETTER 9 // The score of an operator which improves the current tour
+#define SCORE_ACCEPTED 13 // The score of an operator which finds a worse tour that is accepted
+#define INITIAL_WORSENING 0.3 // The initial temperature accepts with probability 0.5 a tour which is worse by this fraction of the average edge cost
+#define FINAL_TEMP_RATIO 0.01 // The ratio between the final and the initial temperature. The temperature decreases geometrically in time
+
+// The destroy operators
+#define DESTROY_RANDOM 0
+#define DESTROY_WORST 1
+#define DESTROY_SPATIAL 2
+#define NUM_DESTROY 3
+
+// The repair operators
+#define REPAIR_CHEAPEST 0
+#define REPAIR_REGRET 1
+#define NUM_REPAIR 2
+
+// The state of the search. The current tour is a doubly linked list, so that removing and inserting a node is O(1)
+typedef struct {
+    instance *inst;
+    int num_nodes;
+    rng_state *rng;
+    int *succ;
+    int *pred;
+    char *in_tour;          // Whether a node is in the tour or it has been removed by the destroy operator
+    kdtree *tree;           // The nodes in the tour
+    int *removed;           // The nodes removed in the current iteration
+    int num_removed;
+    int *near;              // Work memory for the nearest nodes queries
+    double *near_dist;      // The squared distances of the nearest nodes queries. A query asks at most MAX_REMOVED nodes
+    // The insertion cost cache: the two cheapest insertion edges of each removed node, by its index in removed.
+    // An edge is (a, b) with b the successor of a when the cost was computed, so it is stale when succ[a] != b
+    double *best_cost;
+    int *best_a;
+    int *best_b;
+    double *second_cost;
+    int *second_a;
+    int *second_b;
+    int *undo_node;         // The nodes changed in the current iteration with their links before the changes
+    int *undo_succ;
+    int *undo_pred;
+    int undo_size;
+    unsigned int *saved;    // A node is in the undo log when its entry is equal to the stamp
+    unsigned int stamp;
+} alns_state;
+
+/**
+ * Starts a new iteration: empties the undo log and the removed nodes
+ */
+static void begin_iteration(alns_state *st) {
+    if (++(st->stamp) == 0) {
+        memset(st->saved, 0, st->num_nodes * sizeof(unsigned int));
+        st->stamp = 1;
+    }
+    st->undo_size = 0;
+    st->num_removed = 0;
+}
+
+/**
+ * Saves the links of a node in the undo log the first time it changes in the iteration
+ */
+static void save_node(alns_state *st, int v) {
+    if (st->saved[v] == st->stamp) return;
+    st->saved[v] = st->stamp;
+    st->undo_node[st->undo_size] = v;
+    st->undo_succ[st->undo_size] = st->succ[v];
+    st->undo_pred[st->undo_size] = st->pred[v];
+    st->undo_size++;
+}
+
+/**
+ * Goes back to the tour before the iteration. All the removed nodes must be already inserted again
+ */
+static void rollback(alns_state *st) {
+    for (int h = 0; h < st->undo_size; h++) {
+        int v = st->undo_node[h];
+        st->succ[v] = st->undo_succ[h];
+        st->pred[v] = st->undo_pred[h];
+    }
+    st->undo_size = 0;
+}
+
+/**
+ * Removes a node from the tour
+ *
+ * @returns The cost change of the tour
+ */
+static double remove_node(alns_state *st, int v) {
+    int p = st->pred[v];
+    int s = st->succ[v];
+    save_node(st, p);
+    save_node(st, s);
+    save_node(st, v);
+    st->succ[p] = s;
+    st->pred[s] = p;
+    st->in_tour[v] = 0;
+    kdtree_remove(st->tree, v);
+    st->removed[st->num_removed++] = v;
+    return -extra_mileage(p, s, v, st->inst);
+}
+
+/**
+ * Inserts a removed node between a and its successor
+ *
+ * @returns The cost change of the tour
+ */
+static double insert_node(alns_state *st, int v, int a) {
+    int b = st->succ[a];
+    save_node(st, a);
+    save_node(st, b);
+    save_node(st, v);
+    st->succ[a] = v;
+    st->pred[v] = a;
+    st->succ[v] = b;
+    st->pred[b] = v;
+    st->in_tour[v] = 1;
+    kdtree_insert(st->tree, v);
+    return extra_mileage(a, b, v, st->inst);
+}
+
+/**
+ * Removes q random nodes
+ */
+static double destroy_random(alns_state *st, int q) {
+    double delta = 0;
+    while (st->num_removed < q) {
+        int v = rand_choice(0, st->num_nodes, st->rng);
+        if (!st->in_tour[v]) continue;
+        delta += remove_node(st, v);
+    }
+    return delta;
+}
+
+/**
+ * Removes q nodes with a high removal gain. Each node is the one with the highest gain among a few random nodes,
+ * so the most expensive nodes are likely removed without sorting all the nodes
+ */
+static double destroy_worst(alns_state *st, int q) {
+    double delta = 0;
+    while (st->num_removed < q) {
+        int worst = -1;
+        double worst_gain = -DBL_MAX;
+        for (int h = 0; h < WORST_SAMPLE; h++) {
+            int v = rand_choice(0, st->num_nodes, st->rng);
+            if (!st->in_tour[v]) continue;
+            double gain = extra_mileage(st->pred[v], st->succ[v], v, st->inst);
+            if (gain > worst_gain) {
+                worst_gain = gain;
+                worst = v;
+            }
+        }
+        if (worst < 0) continue;
+        delta += remove_node(st, worst);
+    }
+    return delta;
+}
+
+/**
+ * Removes a random node and its q - 1 nearest nodes
+ */
+static double destroy_spatial(alns_state *st, int q) {
+    int seed = rand_choice(0, st->num_nodes, st->rng);
+    int found = kdtree_knn(st->tree, seed, q - 1, st->near, st->near_dist);
+    double delta = remove_node(st, seed);
+    for (int h = 0; h < found; h++) {
+        delta += remove_node(st, st->near[h]);
+    }
+    return delta;
+}
+
+/**
+ * Evaluates the insertion of a removed node between a and its successor and updates its two cheapest edges
+ *
+ * @param st The state of the search
+ * @param slot The index of the node in the removed nodes
+ * @param a The first node of the edge
+ */
+static void consider_edge(alns_state *st, int slot, int a) {
+    if (a == st->best_a[slot] || a == st->second_a[slot]) return;
+    int b = st->succ[a];
+    double cost = extra_mileage(a, b, st->removed[slot], st->inst);
+    if (cost < st->best_cost[slot]) {
+        st->second_cost[slot] = st->best_cost[slot];
+        st->second_a[slot] = st->best_a[slot];
+        st->second_b[slot] = st->best_b[slot];
+        st->best_cost[slot] = cost;
+        st->best_a[slot] = a;
+        st->best_b[slot] = b;
+    } else if (cost < st->second_cost[slot]) {
+        st->second_cost[slot] = cost;
+        st->second_a[slot] = a;
+        st->second_b[slot] = b;
+    }
+}
+
+/**
+ * Computes the two cheapest insertion edges of a removed node among the edges of its nearest nodes in the tour
+ */
+static void compute_insertion(alns_state *st, int slot) {
+    st->best_cost[slot] = DBL_MAX;
+    st->second_cost[slot] = DBL_MAX;
+    st->best_a[slot] = st->best_b[slot] = -1;
+    st->second_a[slot] = st->second_b[slot] = -1;
+    int found = kdtree_knn(st->tree, st->removed[slot], INSERT_NEIGHBOURS, st->near, st->near_dist);
+    for (int h = 0; h < found; h++) {
+        int u = st->near[h];
+        consider_edge(st, slot, u);
+        consider_edge(st, slot, st->pred[u]);
+    }
+}
+
+/**
+ * Moves the cache entry of a removed node to another index
+ */
+static void move_slot(alns_state *st, int from, int to) {
+    st->removed[to] = st->removed[from];
+    st->best_cost[to] = st->best_cost[from];
+    st->best_a[to] = st->best_a[from];
+    st->best_b[to] = st->best_b[from];
+    st->second_cost[to] = st->second_cost[from];
+    st->second_a[to] = st->second_a[from];
+    st->second_b[to] = st->second_b[from];
+}
+
+/**
+ * Inserts back the removed nodes one at a time. Cheapest insertion takes the node with the cheapest insertion,
+ * regret insertion the node with the highest difference between its second and its first cheapest insertion.
+ * After an insertion only the cache entries which use a removed edge are computed again, the other ones
+ * just evaluate the two new edges
+ *
+ * @param st The state of the search
+ * @param op The repair operator
+ * @returns The cost change of the tour
+ */
+static double repair(alns_state *st, int op) {
+    for (int slot = 0; slot < st->num_removed; slot++) { compute_insertion(st, slot); }
+    double delta = 0;
+    int remaining = st->num_removed;
+    while (remaining > 0) {
+        int chosen = 0;
+        for (int slot = 1; slot < remaining; slot++) {
+            if (op == REPAIR_REGRET) {
+                double regret = st->second_cost[slot] == DBL_MAX ? DBL_MAX : st->second_cost[slot] - st->best_cost[slot];
+                double chosen_regret = st->second_cost[chosen] == DBL_MAX ? DBL_MAX : st->second_cost[chosen] - st->best_cost[chosen];
+                if (regret > chosen_regret || (regret == chosen_regret && st->best_cost[slot] < st->best_cost[chosen])) { chosen = slot; }
+            } else if (st->best_cost[slot] < st->best_cost[chosen]) {
+                chosen = slot;
+            }
+        }
+        int v = st->removed[chosen];
+        int a = st->best_a[chosen];
+        delta += insert_node(st, v, a);
+        remaining--;
+        move_slot(st, remaining, chosen);
+
+        for (int slot = 0; slot < remaining; slot++) {
+            int stale = st->succ[st->best_a[slot]] != st->best_b[slot] || (st->second_a[slot] >= 0 && st->succ[st->second_a[slot]] != st->second_b[slot]);
+            if (stale) {
+                compute_insertion(st, slot);
+            } else {
+                consider_edge(st, slot, a);
+                consider_edge(st, slot, v);
+            }
+        }
+    }
+    return delta;
+}
+
+/**
+ * Draws an operator with probability proportional to its weight
+ */
+static int choose_operator(const double *weights, int num_operators, rng_state *rng) {
+    double total = 0;
+    for (int i = 0; i < num_operators; i++) { total += weights[i]; }
+    double r = URAND(rng) * total;
+    for (int i = 0; i < num_operators; i++) {
+        r -= weights[i];
+        if (r < 0) return i;
+    }
+    return num_operators - 1;
+}
+
+/**
+ * Updates the weights of the operators with the scores of the last segment and resets the scores
+ */
+static void update_weights(double *weights, double *scores, int *uses, int num_operators) {
+    for (int i = 0; i < num_operators; i++) {
+        if (uses[i] > 0) { weights[i] = (1 - REACTION_FACTOR) * weights[i] + REACTION_FACTOR * scores[i] / uses[i]; }
+        if (weights[i] < MIN_WEIGHT) { weights[i] = MIN_WEIGHT; }
+        scores[i] = 0;
+        uses[i] = 0;
+    }
+}
+
+int HEU_ALNS(instance *inst) {
+    int n = inst->num_nodes;
+
+    //Set time limit
+    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);}
+    double time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+
+    //Start counting time from now
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+
+    //Compute initial solution: nearest neighbour (or warm start) improved with the local search
+    int status = HEU_initial_tour(inst);
+    if (status) {LOG_E("An error occurred in HEU_initial_tour");}
+    local_search *ls = ls_create(inst);
+    if (ls_load_edges(ls, inst->solution.edges)) {LOG_E("The initial solution is not a tour");}
+    ls_queue_all(ls);
+    ls_optimize(ls);
+    double cost = ls_tour_cost(ls);
+
+    alns_state st;
+    st.inst = inst;
+    st.num_nodes = n;
+    st.rng = &(inst->rng);
+    st.succ = MALLOC(n, int);
+    st.pred = MALLOC(n, int);
+    for (int i = 0; i < n; i++) {
+        st.succ[ls->tour[i]] = ls->tour[(i + 1) % n];
+        st.pred[ls->tour[(i + 1) % n]] = ls->tour[i];
+    }
+    st.in_tour = MALLOC(n, char);
+    memset(st.in_tour, 1, n * sizeof(char));
+    st.tree = kdtree_build(inst);
+    st.removed = MALLOC(n, int);
+    st.num_removed = 0;
+    st.near = MALLOC(n, int);
+    st.near_dist = MALLOC((MAX_REMOVED > INSERT_NEIGHBOURS ? MAX_REMOVED : INSERT_NEIGHBOURS), double);
+    st.best_cost = MALLOC(n, double);
+    st.best_a = MALLOC(n, int);
+    st.best_b = MALLOC(n, int);
+    st.second_cost = MALLOC(n, double);
+    st.second_a = MALLOC(n, int);
+    st.second_b = MALLOC(n, int);
+    st.undo_node = MALLOC(n, int);
+    st.undo_succ = MALLOC(n, int);
+    st.undo_pred = MALLOC(n, int);
+    st.undo_size = 0;
+    st.saved = CALLOC(n, unsigned int);
+    st.stamp = 0;
+
+    int *best_succ = MALLOC(n, int);
+    memcpy(best_succ, st.succ, n * sizeof(int));
+    double best_obj = cost;
+
+    //The number of removed nodes. At least 3 nodes stay in the tour
+    int max_removed = n * MAX_REMOVED_RATE / 100;
+    if (max_removed > MAX_REMOVED) { max_removed = MAX_REMOVED; }
+    if (max_removed < MIN_REMOVED) { max_removed = MIN_REMOVED; }
+    if (max_removed > n - 3) { max_removed = n - 3; }
+    int min_removed = MIN_REMOVED < max_removed ? MIN_REMOVED : max_removed;
+
+    double initial_temp = -INITIAL_WORSENING * (cost / n) / log(0.5);
+    if (inst->params.verbose >= 3) {LOG_I("Initial solution: %0.0f, initial temperature: %f", cost, initial_temp);}
+
+    double destroy_weights[NUM_DESTROY], destroy_scores[NUM_DESTROY];
+    double repair_weights[NUM_REPAIR], repair_scores[NUM_REPAIR];
+    int destroy_uses[NUM_DESTROY], repair_uses[NUM_REPAIR];
+    for (int i = 0; i < NUM_DESTROY; i++) { destroy_weights[i] = 1; destroy_scores[i] = 0; destroy_uses[i] = 0; }
+    for (int i = 0; i < NUM_REPAIR; i++) { repair_weights[i] = 1; repair_scores[i] = 0; repair_uses[i] = 0; }
+
+    long iterations = 0, accepted = 0;
+    while (max_removed >= 1) {
+        //Check elapsed time
+        gettimeofday(&end, 0);
+        double elapsed = get_elapsed_time(start, end);
+        if (elapsed > time_limit) {
+            status = TIME_LIMIT_EXCEEDED;
+            break;
+        }
+        double temp = initial_temp * pow(FINAL_TEMP_RATIO, elapsed / time_limit);
+        iterations++;
+
+        //Destroy and repair the current tour
+        int q = rand_choice(min_removed, max_removed + 1, st.rng);
+        int d = choose_operator(destroy_weights, NUM_DESTROY, st.rng);
+        int r = choose_operator(repair_weights, NUM_REPAIR, st.rng);
+        begin_iteration(&st);
+        double delta;
+        if (d == DESTROY_RANDOM) { delta = destroy_random(&st, q); }
+        else if (d == DESTROY_WORST) { delta = destroy_worst(&st, q); }
+        else { delta = destroy_spatial(&st, q); }
+        delta += repair(&st, r);
+
+        //Simulated annealing acceptance
+        double score = 0;
+        int accept = 1;
+        if (cost + delta < best_obj - EPS) {
+            score = SCORE_BEST;
+            best_obj = cost + delta;
+            memcpy(best_succ, st.succ, n * sizeof(int));
+            if (inst->params.verbose >= 3) {LOG_I("Iteration %ld. Updated incumbent: %0.0f", iterations, best_obj);}
+        } else if (delta < -EPS) {
+            score = SCORE_BETTER;
+        } else if (URAND(st.rng) < exp(-delta / temp)) {
+            if (delta > EPS) { score = SCORE_ACCEPTED; }
+        } else {
+            accept = 0;
+        }
+        if (accept) {
+            cost += delta;
+            accepted++;
+        } else {
+            rollback(&st);
+        }
+
+        destroy_scores[d] += score;
+        destroy_uses[d]++;
+        repair_scores[r] += score;
+        repair_uses[r]++;
+        if (iterations % SEGMENT_LENGTH == 0) {
+            update_weights(destroy_weights, destroy_scores, destroy_uses, NUM_DESTROY);
+            update_weights(repair_weights, repair_scores, repair_uses, NUM_REPAIR);
+            if (inst->params.verbose >= 4) {LOG_I("Current: %0.0f, best: %0.0f, temperature: %f", cost, best_obj, temp);}
+        }
+    }
+
+    if (inst->params.verbose >= 3) {
+        LOG_I("ALNS: %ld iterations, %ld accepted", iterations, accepted);
+        LOG_I("Destroy weights: random %0.2f, worst %0.2f, spatial %0.2f", destroy_weights[DESTROY_RANDOM], destroy_weights[DESTROY_WORST], destroy_weights[DESTROY_SPATIAL]);
+        LOG_I("Repair weights: cheapest %0.2f, regret %0.2f", repair_weights[REPAIR_CHEAPEST], repair_weights[REPAIR_REGRET]);
+    }
+
+    //Polish the best tour with the local search
+    for (int i = 0; i < n; i++) {
+        inst->solution.edges[i].i = i;
+        inst->solution.edges[i].j = best_succ[i];
+    }
+    ls_load_edges(ls, inst->solution.edges);
+    ls_queue_all(ls);
+    ls_optimize(ls);
+    ls_store_edges(ls, inst->solution.edges);
+    inst->solution.obj_best = ls_tour_cost(ls);
+
+    // Free allocations
+    FREE(st.succ);
+    FREE(st.pred);
+    FREE(st.in_tour);
+    kdtree_free(st.tree);
+    FREE(st.removed);
+    FREE(st.near);
+    FREE(st.near_dist);
+    FREE(st.best_cost);
+    FREE(st.best_a);
+    FREE(st.best_b);
+    FREE(st.second_cost);
+    FREE(st.second_a);
+    FREE(st.second_b);
+    FREE(st.undo_node);
+    FREE(st.undo_succ);
+    FREE(st.undo_pred);
+    FREE(st.saved);
+    FREE(best_succ);
+    ls_free(ls);
+    return status;
+}
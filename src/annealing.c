@@ -0,0 +1,233 @@
+#include "annealing.h"
+
+#include "heuristics.h"
+#include "distutil.h"
+#include "localsearch.h"
+
+#include <float.h>
+
+////////////////////////////////////////////////////////
+///////////////// HYPERPARAMETERS //////////////////////
+////////////////////////////////////////////////////////
+#define COOLING_METHOD COOLING_ADAPTIVE // The cooling schedule. COOLING_GEOMETRIC or COOLING_ADAPTIVE
+#define OR_OPT_RATE 0.5 // The probability of drawing an Or-opt move instead of a 2-opt move
+#define EPOCH_RATE 10 // The number of moves drawn between two temperature updates in percentage with the number of nodes. If the problem has 100 nodes and the rate is 10, an epoch has 1000 moves
+#define INITIAL_ACCEPTANCE 0.3 // The probability of accepting the average worsening move at the initial temperature
+#define FINAL_ACCEPTANCE 0.001 // The probability of accepting the average worsening move at the end of the time limit
+#define SAMPLE_MOVES 1000 // The number of random moves used to estimate the average worsening
+#define ADAPTIVE_COOLING 0.95 // With adaptive cooling, the factor which decreases (or the inverse increases) the temperature in each epoch
+#define REHEAT_EPOCHS 200 // The number of epochs without improving the best tour after which a frozen search is reheated
+#define FROZEN_ACCEPTANCE 0.01 // The search is frozen when it accepts less than this fraction of the worsening moves
+#define REHEAT_FACTOR 20.0 // The factor which raises the temperature in a reheat. The temperature never exceeds the initial one
+
+// The cooling schedules
+#define COOLING_GEOMETRIC 0 // The temperature decreases geometrically in time, from the initial to the final one
+#define COOLING_ADAPTIVE 1 // The temperature is tuned so that the acceptance of worsening moves follows a geometric schedule
+
+// A random move drawn from the neighbourhood. It is evaluated without changing the tour
+typedef struct {
+    int type;       // 0 for 2-opt, 1 for Or-opt
+    int a, b, c, d; // 2-opt: removes (a, b), (c, d). Or-opt: the segment a ... b is moved between c and d
+    int reversed;   // Or-opt: whether the segment is inserted reversed
+    double delta;   // The cost change of the move
+} sa_move;
+
+/**
+ * Draws a random 2-opt move which adds the edge between a random node and one of its candidates
+ * 
+ * @returns 1 if the move is valid, 0 otherwise
+ */
+static int random_2opt(local_search *ls, sa_move *move, rng_state *rng) {
+    int k = ls->cand->k;
+    int a = rand_choice(0, ls->num_nodes, rng);
+    int c = ls->cand->neighbours[(long) a * k + rand_choice(0, k, rng)];
+    int dir = URAND(rng) < 0.5;
+    int b = dir ? ls_succ(ls, a) : ls_pred(ls, a);
+    int d = dir ? ls_succ(ls, c) : ls_pred(ls, c);
+    if (c == b || d == a) return 0;
+    move->type = 0;
+    move->a = a; move->b = b; move->c = c; move->d = d;
+    move->delta = ls_edge_cost(ls, a, c) + ls_edge_cost(ls, b, d) - ls_edge_cost(ls, a, b) - ls_edge_cost(ls, c, d);
+    return 1;
+}
+
+/**
+ * Draws a random Or-opt move: a segment of 1 to 3 nodes starting from a random node is moved next to
+ * a candidate of the node, in the orientation with the lower cost
+ * 
+ * @returns 1 if the move is valid, 0 otherwise
+ */
+static int random_oropt(local_search *ls, sa_move *move, rng_state *rng) {
+    int k = ls->cand->k;
+    int len = rand_choice(1, 4, rng);
+    if (len + 3 > ls->num_nodes) return 0;
+    int s1 = rand_choice(0, ls->num_nodes, rng);
+    int s2 = s1;
+    int mid = s1;
+    for (int h = 1; h < len; h++) {
+        s2 = ls_succ(ls, s2);
+        if (h == 1) { mid = s2; }
+    }
+    int c = ls->cand->neighbours[(long) s1 * k + rand_choice(0, k, rng)];
+    // The edge (t1, t2) where t2 follows t1
+    int t1 = c, t2 = ls_succ(ls, c);
+    if (URAND(rng) < 0.5) {
+        t1 = ls_pred(ls, c);
+        t2 = c;
+    }
+    int p = ls_pred(ls, s1);
+    int nx = ls_succ(ls, s2);
+    if (t1 == s1 || t1 == s2 || t1 == mid || t2 == s1 || t2 == s2 || t2 == mid || t2 == p) return 0;
+    double gain = ls_edge_cost(ls, p, s1) + ls_edge_cost(ls, s2, nx) - ls_edge_cost(ls, p, nx);
+    double removed = ls_edge_cost(ls, t1, t2);
+    double add_fwd = ls_edge_cost(ls, t1, s1) + ls_edge_cost(ls, s2, t2) - removed;
+    double add_rev = ls_edge_cost(ls, t1, s2) + ls_edge_cost(ls, s1, t2) - removed;
+    move->type = 1;
+    move->a = s1; move->b = s2; move->c = t1; move->d = t2;
+    move->reversed = add_rev < add_fwd;
+    move->delta = (move->reversed ? add_rev : add_fwd) - gain;
+    return 1;
+}
+
+static int random_move(local_search *ls, sa_move *move, rng_state *rng) {
+    if (URAND(rng) < OR_OPT_RATE) return random_oropt(ls, move, rng);
+    return random_2opt(ls, move, rng);
+}
+
+static void apply_move(local_search *ls, const sa_move *move) {
+    if (move->type == 0) {
+        ls_2opt_move(ls, move->a, move->b, move->c, move->d);
+    } else {
+        ls_move_segment(ls, move->a, move->b, move->c, move->d, move->reversed);
+    }
+}
+
+/**
+ * Estimates the average cost increase of the worsening moves around the current tour
+ */
+static double average_worsening(local_search *ls, rng_state *rng) {
+    sa_move move;
+    double sum = 0;
+    int count = 0;
+    for (int h = 0; h < SAMPLE_MOVES; h++) {
+        if (!random_move(ls, &move, rng) || move.delta <= EPS) continue;
+        sum += move.delta;
+        count++;
+    }
+    return count > 0 ? sum / count : 1.0;
+}
+
+int HEU_Simulated_annealing(instance *inst) {
+    int status = 0;
+
+    //Set time limit
+    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);}
+    double time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+
+    //Start counting time from now
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+
+    //Compute initial solution
+    status = HEU_initial_tour(inst);
+    if (status) {LOG_E("An error occurred in HEU_initial_tour");}
+    local_search *ls = ls_create(inst);
+    if (ls_load_edges(ls, inst->solution.edges)) {LOG_E("The initial solution is not a tour");}
+    rng_state *rng = &(inst->rng);
+
+    double cost = ls_tour_cost(ls);
+    double best_obj = cost;
+    int *best_tour = MALLOC(inst->num_nodes, int);
+    ls_store(ls, best_tour);
+    int best_saved = 1; // Whether best_tour is the best tour. The best tour is copied only when the search leaves it
+
+    double worsening = average_worsening(ls, rng);
+    double initial_temp = -worsening / log(INITIAL_ACCEPTANCE);
+    double final_temp = -worsening / log(FINAL_ACCEPTANCE);
+    double temp = initial_temp;
+    if (inst->params.verbose >= 3) {LOG_I("Initial solution: %0.0f, initial temperature: %f", cost, initial_temp);}
+
+    long epoch_length = (long) inst->num_nodes * EPOCH_RATE;
+    long evaluated = 0, accepted = 0;
+    int reheats = 0;
+    int last_improvement = 0;
+    double prev_elapsed = 0;
+    sa_move move;
+    for (int epoch = 1; ; epoch++) {
+        long uphill = 0, uphill_accepted = 0;
+        for (long h = 0; h < epoch_length; h++) {
+            if (!random_move(ls, &move, rng)) continue;
+            evaluated++;
+            if (move.delta > EPS) {
+                uphill++;
+                if (URAND(rng) >= exp(-move.delta / temp)) continue;
+                uphill_accepted++;
+                if (!best_saved) {
+                    // The current tour is the best one and the search is leaving it
+                    ls_store(ls, best_tour);
+                    best_saved = 1;
+                }
+            }
+            apply_move(ls, &move);
+            accepted++;
+            cost += move.delta;
+            if (cost < best_obj - EPS) {
+                best_obj = cost;
+                best_saved = 0;
+                last_improvement = epoch;
+            }
+        }
+
+        //Check elapsed time
+        gettimeofday(&end, 0);
+        double elapsed = get_elapsed_time(start, end);
+        if (elapsed > time_limit) {
+            status = TIME_LIMIT_EXCEEDED;
+            break;
+        }
+        if (inst->params.verbose >= 4) {LOG_I("Current: %0.0f, best: %0.0f, temperature: %f", cost, best_obj, temp);}
+
+        //Cool down so that the final temperature is reached at the time limit
+        if (COOLING_METHOD == COOLING_ADAPTIVE) {
+            double target = INITIAL_ACCEPTANCE * pow(FINAL_ACCEPTANCE / INITIAL_ACCEPTANCE, elapsed / time_limit);
+            double ratio = uphill > 0 ? (double) uphill_accepted / uphill : 0;
+            temp = ratio > target ? temp * ADAPTIVE_COOLING : temp / ADAPTIVE_COOLING;
+        } else {
+            double remaining = time_limit - elapsed;
+            temp *= pow(final_temp / temp, (elapsed - prev_elapsed) / (remaining + elapsed - prev_elapsed));
+        }
+        prev_elapsed = elapsed;
+
+        //Reheat from the best tour when the search is frozen and stagnates
+        int frozen = uphill_accepted < FROZEN_ACCEPTANCE * uphill;
+        if (frozen && epoch - last_improvement >= REHEAT_EPOCHS) {
+            if (!best_saved) {
+                ls_store(ls, best_tour);
+                best_saved = 1;
+            }
+            ls_load(ls, best_tour);
+            cost = best_obj;
+            best_saved = 0; // The current tour is the saved best one
+            temp = temp * REHEAT_FACTOR < initial_temp ? temp * REHEAT_FACTOR : initial_temp;
+            last_improvement = epoch;
+            reheats++;
+            if (inst->params.verbose >= 4) {LOG_I("Reheat to temperature %f", temp);}
+        }
+    }
+
+    if (inst->params.verbose >= 3) {
+        LOG_I("Simulated annealing: %ld moves evaluated, %ld accepted, %d reheats", evaluated, accepted, reheats);
+    }
+
+    //Polish the best tour with the local search
+    if (!best_saved) { ls_store(ls, best_tour); }
+    ls_load(ls, best_tour);
+    ls_queue_all(ls);
+    ls_optimize(ls);
+    ls_store_edges(ls, inst->solution.edges);
+    inst->solution.obj_best = ls_tour_cost(ls);
+
+    FREE(best_tour);
+    ls_free(ls);
+    return status;
+}
@@ -57,7 +57,7 @@ static int CPXPUBLIC SEC_cuts_callback_candidate(CPXCALLBACKCONTEXTptr context,
         FREE(indexes);
         FREE(values);
         
-    } else if (num_comp == 1 && inst->params.callback_2opt) {
+    } else if (num_comp == 1 && inst->params.callback_2opt && inst->sparse == NULL) {
         // Here we have a candidate TSP solution. It is not optimal and it may have crossing edges. We want to help cplex on finding a better
         // solution applying the 2-opt algorithm on the solution just found. 
 
@@ -118,7 +118,9 @@ static int violated_cuts_callback(double cutval, int num_nodes, int* members, vo
     for (int i = 0; i < num_nodes; i++) {
         for (int j = 0; j < num_nodes; j++) {
             if (members[i] >= members[j]) { continue; } // undirected graph. If the node in index i is greated than the node in index j, we skip since (i,j) = (j,i)
-            edges[k] = x_udir_pos(members[i], members[j], inst->num_nodes);
+            int col = x_udir_col(inst, members[i], members[j]);
+            if (col < 0) { continue; } // The edge is not in the model
+            edges[k] = col;
             values[k] = 1.0;
             k++;
             //LOG_D("X(%d,%d)", members[i], members[j]);
@@ -126,8 +128,9 @@ static int violated_cuts_callback(double cutval, int num_nodes, int* members, vo
     }
     int purgeable = CPX_USECUT_FILTER;
 	int local = 0;
-    int status = CPXcallbackaddusercuts(context, 1, num_edges, &rhs, &sense, &matbeg, edges, values, &purgeable, &local);
+    int status = CPXcallbackaddusercuts(context, 1, k, &rhs, &sense, &matbeg, edges, values, &purgeable, &local);
     FREE(values);
+    FREE(edges);
     if (status) LOG_E("CPXcallbackaddusercuts() when conn comps = 1. Error code %d", status);
     return 0;
 }
@@ -145,23 +148,10 @@ static int CPXPUBLIC SEC_cuts_callback_relaxation(CPXCALLBACKCONTEXTptr context,
     //LOG_D("Current node %d", node);
     //LOG_D("Thread id: %d\n", threadid);
 
-    #if __LINUX__ 
-
-    // Uses the thread_seeds array in the instance to obtain a seed for randomness
-    unsigned int seed = inst->thread_seeds[threadid];
-    // Modifying an array on the fly in a threaded code is not a great idea. 
-    // However, each thread accesses only in it's specific index on the array. 
-    // So it cannot occur that two different threads access at the same location
-    // in the array causing race condition
-    inst->thread_seeds[threadid] = seed + 1; 
-    double rand_num = ((double) rand_r(&seed)) / RAND_MAX; // For macos rand_r is broken. It doesn't generate real random numbers
+    // Each thread draws from its own random stream. Each thread accesses only in its specific index
+    // of the array so no race condition can occur
+    double rand_num = URAND(&(inst->thread_rngs[threadid]));
     if (rand_num > 0.1) return 0; // Hyperparameter tuning
-
-    #else
-
-    if (node % 10 != 0) return 0;
-
-    #endif
     //if (depth > 5) return 0; // Hyperparameter tuning
     if (inst->params.verbose >= 5) {
         LOG_I("Relaxation cut");
@@ -179,13 +169,22 @@ static int CPXPUBLIC SEC_cuts_callback_relaxation(CPXCALLBACKCONTEXTptr context,
     int k = 0;
 
     int num_edges = 0;
-    for (int i = 0; i < inst->num_nodes; i++) {
-        for (int j = i+1; j < inst->num_nodes; j++) {
-            //if (fabs(xstar[x_udir_pos(i, j, inst->num_nodes)]) <= EPS) continue;
-            elist[k++] = i;
-            elist[k++] = j;
+    if (inst->sparse != NULL) {
+        // The columns are the edges of the sparse graph
+        for (int c = 0; c < inst->sparse->num_edges; c++) {
+            elist[k++] = inst->sparse->edges[c].i;
+            elist[k++] = inst->sparse->edges[c].j;
             num_edges++;
         }
+    } else {
+        for (int i = 0; i < inst->num_nodes; i++) {
+            for (int j = i+1; j < inst->num_nodes; j++) {
+                //if (fabs(xstar[x_udir_pos(i, j, inst->num_nodes)]) <= EPS) continue;
+                elist[k++] = i;
+                elist[k++] = j;
+                num_edges++;
+            }
+        }
     }
     // Checking whether or not the graph is connected with the fractional solution.
     status = CCcut_connect_components(inst->num_nodes, num_edges, elist, xstar, &numcomps, &compscount, &comps);
@@ -0,0 +1,42 @@
+#include "candidates.h"
+
+#include "kdtree.h"
+
+candidate_list* get_candidate_lists(instance *inst) {
+    if (inst->candidates == NULL) {
+        inst->candidates = build_candidate_lists(inst, inst->params.num_candidates);
+    }
+    return inst->candidates;
+}
+
+candidate_list* build_candidate_lists(instance *inst, int k) {
+    if (k > inst->num_nodes - 1) { k = inst->num_nodes - 1; }
+    if (k < 1) { LOG_E("The number of candidates must be positive"); }
+    candidate_list *cand = MALLOC(1, candidate_list);
+    cand->num_nodes = inst->num_nodes;
+    cand->k = k;
+    cand->neighbours = MALLOC((long) inst->num_nodes * k, int);
+
+    kdtree *tree = kdtree_build(inst);
+    double *sqdist = MALLOC(k, double);
+    for (int i = 0; i < inst->num_nodes; i++) {
+        kdtree_knn(tree, i, k, &(cand->neighbours[(long) i * k]), sqdist);
+    }
+    FREE(sqdist);
+    kdtree_free(tree);
+    return cand;
+}
+
+void free_candidate_lists(candidate_list *cand) {
+    if (cand == NULL) return;
+    FREE(cand->neighbours);
+    free(cand);
+}
+
+int is_candidate(const candidate_list *cand, int i, int j) {
+    const int *list = &(cand->neighbours[(long) i * cand->k]);
+    for (int c = 0; c < cand->k; c++) {
+        if (list[c] == j) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,432 @@
+#include "eax.h"
+
+#include "distutil.h"
+
+#include <float.h>
+
+eax_workspace* eax_create(int num_nodes) {
+    eax_workspace *ws = MALLOC(1, eax_workspace);
+    ws->num_nodes = num_nodes;
+    ws->adj_a = MALLOC(2 * num_nodes, int);
+    ws->adj_b = MALLOC(2 * num_nodes, int);
+    ws->rem_a = MALLOC(2 * num_nodes, int);
+    ws->deg_a = MALLOC(num_nodes, int);
+    ws->rem_b = MALLOC(2 * num_nodes, int);
+    ws->deg_b = MALLOC(num_nodes, int);
+    ws->route = MALLOC((2 * num_nodes + 1), int);
+    ws->route_pos = MALLOC(2 * num_nodes, int);
+    MEMSET(ws->route_pos, -1, 2 * num_nodes, int);
+    ws->cycles = MALLOC(2 * num_nodes, int);
+    ws->cycle_beg = MALLOC((num_nodes + 1), int);
+    ws->cycle_order = MALLOC(num_nodes, int);
+    ws->num_cycles = 0;
+    ws->order_a = NULL;
+    ws->pos_a = MALLOC(num_nodes, int);
+    ws->cuts = MALLOC(num_nodes, int);
+    ws->num_cuts = 0;
+    ws->child_adj = MALLOC(2 * num_nodes, int);
+    ws->comp = MALLOC(num_nodes, int);
+    ws->comp_size = MALLOC(num_nodes, int);
+    ws->comp_node = MALLOC(num_nodes, int);
+    ws->subtours = heap_create(num_nodes);
+    ws->touched = MALLOC(num_nodes, int);
+    ws->is_touched = CALLOC(num_nodes, char);
+    ws->num_touched = 0;
+    ws->best_nodes = MALLOC(num_nodes, int);
+    ws->best_adj = MALLOC(2 * num_nodes, int);
+    ws->num_best = 0;
+    return ws;
+}
+
+void eax_free(eax_workspace *ws) {
+    if (ws == NULL) return;
+    FREE(ws->adj_a);
+    FREE(ws->adj_b);
+    FREE(ws->rem_a);
+    FREE(ws->deg_a);
+    FREE(ws->rem_b);
+    FREE(ws->deg_b);
+    FREE(ws->route);
+    FREE(ws->route_pos);
+    FREE(ws->cycles);
+    FREE(ws->cycle_beg);
+    FREE(ws->cycle_order);
+    FREE(ws->pos_a);
+    FREE(ws->cuts);
+    FREE(ws->child_adj);
+    FREE(ws->comp);
+    FREE(ws->comp_size);
+    FREE(ws->comp_node);
+    heap_free(ws->subtours);
+    FREE(ws->touched);
+    FREE(ws->is_touched);
+    FREE(ws->best_nodes);
+    FREE(ws->best_adj);
+    FREE(ws);
+}
+
+/**
+ * Stores the two neighbours of each node of a tour
+ *
+ * @param chromosome The tour in order representation
+ * @param n The number of nodes
+ * @param adj Where the neighbours are stored: adj[2 * v] is the predecessor and adj[2 * v + 1] the successor of v
+ */
+static void tour_to_adjacency(const int *chromosome, int n, int *adj) {
+    for (int i = 0; i < n; i++) {
+        int v = chromosome[i];
+        adj[2 * v] = chromosome[(i + n - 1) % n];
+        adj[2 * v + 1] = chromosome[(i + 1) % n];
+    }
+}
+
+/**
+ * Removes the edge (u, v) from the lists of remaining edges of u and v
+ */
+static void remove_edge(int *rem, int *deg, int u, int v) {
+    for (int k = 0; k < deg[u]; k++) {
+        if (rem[2 * u + k] == v) { rem[2 * u + k] = rem[2 * u + --deg[u]]; break; }
+    }
+    for (int k = 0; k < deg[v]; k++) {
+        if (rem[2 * v + k] == u) { rem[2 * v + k] = rem[2 * v + --deg[v]]; break; }
+    }
+}
+
+/**
+ * Replaces the neighbour old_node of node v with new_node
+ */
+static void replace_neighbour(int *adj, int v, int old_node, int new_node) {
+    if (adj[2 * v] == old_node) { adj[2 * v] = new_node; }
+    else { adj[2 * v + 1] = new_node; }
+}
+
+/**
+ * Gives the neighbour of v in a 2-regular graph which is not prev
+ */
+static int next_node(const int *adj, int v, int prev) {
+    return adj[2 * v] != prev ? adj[2 * v] : adj[2 * v + 1];
+}
+
+/**
+ * Remembers that the neighbours of v in the offspring are changed by the current trial
+ */
+static void touch(eax_workspace *ws, int v) {
+    if (ws->is_touched[v]) return;
+    ws->is_touched[v] = 1;
+    ws->touched[ws->num_touched++] = v;
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int lhs = *((const int*) a);
+    int rhs = *((const int*) b);
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+/**
+ * Gives the segment of parent A which contains the node v. O(log num_cuts)
+ */
+static int segment_of(const eax_workspace *ws, int v) {
+    int p = ws->pos_a[v];
+    int lo = 0, hi = ws->num_cuts; // The first cut which is not before p
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ws->cuts[mid] < p) { lo = mid + 1; } else { hi = mid; }
+    }
+    return lo == 0 ? ws->num_cuts - 1 : lo - 1; // The last segment wraps around the end of parent A
+}
+
+/**
+ * Gives the subtour of the offspring which contains the node v
+ */
+static int subtour_of(eax_workspace *ws, int v) {
+    int t = segment_of(ws, v);
+    while (ws->comp[t] != t) {
+        ws->comp[t] = ws->comp[ws->comp[t]]; // Path halving
+        t = ws->comp[t];
+    }
+    return t;
+}
+
+/**
+ * Decomposes the edges which are not shared by the two parents in AB-cycles with a random alternating walk.
+ * The walk starts with an A edge and each time it reaches a node already in the walk with the same parity,
+ * the closed part of the walk is an AB-cycle and it is removed from the walk.
+ */
+static void build_ab_cycles(eax_workspace *ws, rng_state *rng) {
+    int n = ws->num_nodes;
+    for (int v = 0; v < n; v++) {
+        ws->deg_a[v] = ws->deg_b[v] = 0;
+        for (int k = 0; k < 2; k++) {
+            int a = ws->adj_a[2 * v + k];
+            if (a != ws->adj_b[2 * v] && a != ws->adj_b[2 * v + 1]) { ws->rem_a[2 * v + ws->deg_a[v]++] = a; }
+            int b = ws->adj_b[2 * v + k];
+            if (b != ws->adj_a[2 * v] && b != ws->adj_a[2 * v + 1]) { ws->rem_b[2 * v + ws->deg_b[v]++] = b; }
+        }
+    }
+
+    int *route = ws->route;
+    int *pos = ws->route_pos;
+    int total = 0;
+    ws->num_cycles = 0;
+    ws->cycle_beg[0] = 0;
+    int first = rand_choice(0, n, rng);
+    for (int iter = 0; iter < n; iter++) {
+        int s = (first + iter) % n;
+        if (ws->deg_a[s] == 0) continue;
+        route[0] = s;
+        pos[2 * s] = 0;
+        int len = 1;
+        while (1) {
+            int u = route[len - 1];
+            int w;
+            if ((len - 1) % 2 == 0) {
+                // An A edge is needed. Only the starting node can have no A edges left
+                if (ws->deg_a[u] == 0) break;
+                w = ws->rem_a[2 * u + rand_choice(0, ws->deg_a[u], rng)];
+                remove_edge(ws->rem_a, ws->deg_a, u, w);
+            } else {
+                w = ws->rem_b[2 * u + rand_choice(0, ws->deg_b[u], rng)];
+                remove_edge(ws->rem_b, ws->deg_b, u, w);
+            }
+            int q = len++;
+            route[q] = w;
+            int p = pos[2 * w + q % 2];
+            if (p < 0) {
+                pos[2 * w + q % 2] = q;
+                continue;
+            }
+
+            // route[p] ... route[q] is an AB-cycle. It is stored starting with an A edge
+            int start = p % 2 == 0 ? p : p + 1;
+            for (int k = 0; k < q - p; k++) {
+                ws->cycles[total++] = route[start + k <= q - 1 ? start + k : p + (start + k - q)];
+            }
+            ws->cycle_beg[++ws->num_cycles] = total;
+            for (int k = p + 1; k <= q; k++) { pos[2 * route[k] + k % 2] = -1; }
+            pos[2 * w + p % 2] = p;
+            len = p + 1;
+        }
+        pos[2 * s] = -1;
+    }
+}
+
+/**
+ * Labels the subtours of the offspring and pushes them in the heap ordered by size. The subtours are made of
+ * whole segments of parent A joined by the B edges of the AB-cycle, so they are walked segment by segment
+ * in O(num_cuts log num_cuts)
+ *
+ * @returns The number of subtours
+ */
+static int label_subtours(eax_workspace *ws) {
+    int n = ws->num_nodes;
+    int m = ws->num_cuts;
+    const int *order = ws->order_a;
+    for (int t = 0; t < m; t++) { ws->comp[t] = -1; }
+    heap_clear(ws->subtours);
+    int num_comps = 0;
+    for (int t = 0; t < m; t++) {
+        if (ws->comp[t] >= 0) continue;
+        int size = 0;
+        int seg = t;
+        int enter = order[(ws->cuts[t] + 1) % n];  // The node from which the walk enters the segment
+        int from = ws->child_adj[2 * enter];        // The node before it. It matters only for the segments of a single node
+        while (1) {
+            ws->comp[seg] = t;
+            int first_pos = ws->cuts[seg] + 1;
+            int last_pos = seg + 1 < m ? ws->cuts[seg + 1] : ws->cuts[0] + n;
+            size += last_pos - first_pos + 1;
+            int first = order[first_pos % n], last = order[last_pos % n];
+            int exit, before; // The node from which the walk leaves the segment and the node before it
+            if (first == last) {
+                exit = enter;
+                before = from;
+            } else if (enter == first) {
+                exit = last;
+                before = order[(last_pos - 1) % n];
+            } else {
+                exit = first;
+                before = order[(first_pos + 1) % n];
+            }
+            int next = next_node(ws->child_adj, exit, before);
+            seg = segment_of(ws, next);
+            if (ws->comp[seg] >= 0) break; // Back to the first segment
+            from = exit;
+            enter = next;
+        }
+        ws->comp_size[t] = size;
+        ws->comp_node[t] = order[(ws->cuts[t] + 1) % n];
+        heap_push(ws->subtours, t, size);
+        num_comps++;
+    }
+    return num_comps;
+}
+
+/**
+ * Evaluates the exchanges which merge the edge (u, u2) of a subtour with the edge (v, v2) of another one
+ */
+static void evaluate_merge(instance *inst, const eax_workspace *ws, int u, int u2, int v, double *best_delta, int *best_move) {
+    double removed = calc_dist(u, u2, inst);
+    for (int k = 0; k < 2; k++) {
+        int v2 = ws->child_adj[2 * v + k];
+        double removed_v = removed + calc_dist(v, v2, inst);
+        double delta1 = calc_dist(u, v, inst) + calc_dist(u2, v2, inst) - removed_v;   // (u, v) and (u2, v2)
+        double delta2 = calc_dist(u, v2, inst) + calc_dist(u2, v, inst) - removed_v;   // (u, v2) and (u2, v)
+        if (delta1 < *best_delta) {
+            *best_delta = delta1;
+            best_move[0] = u; best_move[1] = u2; best_move[2] = v; best_move[3] = v2;
+        }
+        if (delta2 < *best_delta) {
+            *best_delta = delta2;
+            best_move[0] = u; best_move[1] = u2; best_move[2] = v2; best_move[3] = v;
+        }
+    }
+}
+
+/**
+ * Merges the subtours of the offspring into a single tour. The smallest subtour is merged each time
+ * with the cheapest exchange of one of its edges with an edge of another subtour which contains a candidate of its nodes
+ *
+ * @returns The cost change of the merges
+ */
+static double merge_subtours(instance *inst, eax_workspace *ws) {
+    int n = ws->num_nodes;
+    candidate_list *cand = inst->candidates;
+    double delta = 0;
+    int num_comps = label_subtours(ws);
+    while (num_comps > 1) {
+        int c = heap_pop(ws->subtours, NULL);
+        double best_delta = DBL_MAX;
+        int best_move[4]; // Removing (u, u2) and (v2, v), adding (u, v) and (u2, v2)
+
+        int start = ws->comp_node[c];
+        int prev = ws->child_adj[2 * start], cur = start;
+        do {
+            int next = next_node(ws->child_adj, cur, prev);
+            for (int k = 0; k < cand->k; k++) {
+                int v = cand->neighbours[(long) cur * cand->k + k];
+                if (subtour_of(ws, v) == c) continue;
+                evaluate_merge(inst, ws, cur, next, v, &best_delta, best_move);
+            }
+            prev = cur;
+            cur = next;
+        } while (cur != start);
+
+        if (best_delta == DBL_MAX) {
+            // No candidate is outside the subtour. All the nodes are scanned
+            prev = ws->child_adj[2 * start];
+            cur = start;
+            do {
+                int next = next_node(ws->child_adj, cur, prev);
+                for (int v = 0; v < n; v++) {
+                    if (subtour_of(ws, v) == c) continue;
+                    evaluate_merge(inst, ws, cur, next, v, &best_delta, best_move);
+                }
+                prev = cur;
+                cur = next;
+            } while (cur != start);
+        }
+
+        // The smallest subtour joins the other subtour
+        int u = best_move[0], u2 = best_move[1], v = best_move[2], v2 = best_move[3];
+        int target = subtour_of(ws, v);
+        ws->comp[c] = target;
+        ws->comp_size[target] += ws->comp_size[c];
+        ws->comp_size[c] = 0;
+
+        replace_neighbour(ws->child_adj, u, u2, v);
+        replace_neighbour(ws->child_adj, u2, u, v2);
+        replace_neighbour(ws->child_adj, v, v2, u);
+        replace_neighbour(ws->child_adj, v2, v, u2);
+        touch(ws, u); touch(ws, u2); touch(ws, v); touch(ws, v2);
+        delta += best_delta;
+        heap_push(ws->subtours, target, ws->comp_size[target]);
+        num_comps--;
+    }
+    return delta;
+}
+
+double eax_crossover(instance *inst, eax_workspace *ws, const int *parent_a, double cost_a, const int *parent_b, int *child, int num_trials, rng_state *rng) {
+    int n = ws->num_nodes;
+    tour_to_adjacency(parent_a, n, ws->adj_a);
+    tour_to_adjacency(parent_b, n, ws->adj_b);
+    for (int i = 0; i < n; i++) { ws->pos_a[parent_a[i]] = i; }
+    ws->order_a = parent_a;
+    build_ab_cycles(ws, rng);
+
+    if (num_trials > ws->num_cycles) { num_trials = ws->num_cycles; }
+    for (int c = 0; c < ws->num_cycles; c++) { ws->cycle_order[c] = c; }
+
+    // Each trial changes the offspring in place and restores only the nodes it changed
+    memcpy(ws->child_adj, ws->adj_a, 2 * n * sizeof(int));
+    double best_cost = DBL_MAX;
+    for (int trial = 0; trial < num_trials; trial++) {
+        // The AB-cycles are tried in random order without repetitions
+        int pick = rand_choice(trial, ws->num_cycles, rng);
+        int cycle = ws->cycle_order[pick];
+        ws->cycle_order[pick] = ws->cycle_order[trial];
+        ws->cycle_order[trial] = cycle;
+        int beg = ws->cycle_beg[cycle], end = ws->cycle_beg[cycle + 1];
+
+        // Intermediate solution: parent A without the A edges of the cycle and with its B edges
+        double delta = 0;
+        ws->num_cuts = 0;
+        int len = end - beg;
+        for (int k = 0; k < len; k += 2) {
+            int a = ws->cycles[beg + k], b = ws->cycles[beg + (k + 1) % len];
+            delta -= calc_dist(a, b, inst);
+            ws->cuts[ws->num_cuts++] = ws->adj_a[2 * a + 1] == b ? ws->pos_a[a] : ws->pos_a[b];
+            replace_neighbour(ws->child_adj, a, b, -1);
+            replace_neighbour(ws->child_adj, b, a, -1);
+            touch(ws, a);
+            touch(ws, b);
+        }
+        for (int k = 1; k < len; k += 2) {
+            int a = ws->cycles[beg + k], b = ws->cycles[beg + (k + 1) % len];
+            delta += calc_dist(a, b, inst);
+            replace_neighbour(ws->child_adj, a, -1, b);
+            replace_neighbour(ws->child_adj, b, -1, a);
+        }
+        qsort(ws->cuts, ws->num_cuts, sizeof(int), compare_ints);
+
+        delta += merge_subtours(inst, ws);
+
+        if (cost_a + delta < best_cost) {
+            best_cost = cost_a + delta;
+            for (int h = 0; h < ws->num_touched; h++) {
+                int v = ws->touched[h];
+                ws->best_nodes[h] = v;
+                ws->best_adj[2 * h] = ws->child_adj[2 * v];
+                ws->best_adj[2 * h + 1] = ws->child_adj[2 * v + 1];
+            }
+            ws->num_best = ws->num_touched;
+        }
+        for (int h = 0; h < ws->num_touched; h++) {
+            int v = ws->touched[h];
+            ws->child_adj[2 * v] = ws->adj_a[2 * v];
+            ws->child_adj[2 * v + 1] = ws->adj_a[2 * v + 1];
+            ws->is_touched[v] = 0;
+        }
+        ws->num_touched = 0;
+    }
+
+    if (best_cost == DBL_MAX) {
+        // The parents are the same tour
+        memcpy(child, parent_a, n * sizeof(int));
+        return cost_a;
+    }
+
+    // Only the best offspring is built
+    for (int h = 0; h < ws->num_best; h++) {
+        int v = ws->best_nodes[h];
+        ws->child_adj[2 * v] = ws->best_adj[2 * h];
+        ws->child_adj[2 * v + 1] = ws->best_adj[2 * h + 1];
+    }
+    int prev = ws->child_adj[0], cur = 0;
+    for (int i = 0; i < n; i++) {
+        child[i] = cur;
+        int next = next_node(ws->child_adj, cur, prev);
+        prev = cur;
+        cur = next;
+    }
+    return best_cost;
+}
@@ -0,0 +1,93 @@
+#include "edgemap.h"
+
+static long long edge_key(const edge_map *map, int i, int j) {
+    return i < j ? (long long) i * map->num_nodes + j : (long long) j * map->num_nodes + i;
+}
+
+/**
+ * Gives the slot of a key in the table, or the empty slot where it should be inserted
+ */
+static long find_slot(const edge_map *map, long long key) {
+    unsigned long long h = (unsigned long long) key * 0x9E3779B97F4A7C15ULL; // Fibonacci hashing
+    long slot = (long) (h >> 32) & (map->capacity - 1);
+    while (map->keys[slot] != -1 && map->keys[slot] != key) {
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * Allocates new empty slots and moves there the entries of the old slots accepted by keep (all of them if keep is NULL)
+ */
+static void rebuild(edge_map *map, long capacity, int (*keep)(int value, void *data), void *data) {
+    long old_capacity = map->capacity;
+    long long *old_keys = map->keys;
+    int *old_values = map->values;
+    map->capacity = capacity;
+    map->count = 0;
+    map->keys = MALLOC(map->capacity, long long);
+    MEMSET(map->keys, -1, map->capacity, long long);
+    map->values = MALLOC(map->capacity, int);
+    for (long s = 0; s < old_capacity; s++) {
+        if (old_keys[s] == -1 || (keep != NULL && !keep(old_values[s], data))) continue;
+        long slot = find_slot(map, old_keys[s]);
+        map->keys[slot] = old_keys[s];
+        map->values[slot] = old_values[s];
+        map->count++;
+    }
+    FREE(old_keys);
+    FREE(old_values);
+}
+
+edge_map* edge_map_create(int num_nodes, long capacity) {
+    edge_map *map = MALLOC(1, edge_map);
+    map->num_nodes = num_nodes;
+    map->capacity = 16;
+    while (map->capacity < capacity) { map->capacity *= 2; }
+    map->count = 0;
+    map->keys = MALLOC(map->capacity, long long);
+    MEMSET(map->keys, -1, map->capacity, long long);
+    map->values = MALLOC(map->capacity, int);
+    return map;
+}
+
+void edge_map_free(edge_map *map) {
+    if (map == NULL) return;
+    FREE(map->keys);
+    FREE(map->values);
+    FREE(map);
+}
+
+int edge_map_get(const edge_map *map, int i, int j, int *value) {
+    long slot = find_slot(map, edge_key(map, i, j));
+    if (map->keys[slot] == -1) return 0;
+    *value = map->values[slot];
+    return 1;
+}
+
+int edge_map_put(edge_map *map, int i, int j, int value) {
+    if (2 * (map->count + 1) > map->capacity) { edge_map_grow(map); }
+    long long key = edge_key(map, i, j);
+    long slot = find_slot(map, key);
+    int inserted = map->keys[slot] == -1;
+    if (inserted) {
+        map->keys[slot] = key;
+        map->count++;
+    }
+    map->values[slot] = value;
+    return inserted;
+}
+
+void edge_map_grow(edge_map *map) {
+    rebuild(map, 2 * map->capacity, NULL, NULL);
+}
+
+void edge_map_filter(edge_map *map, int (*keep)(int value, void *data), void *data) {
+    long alive = 0;
+    for (long s = 0; s < map->capacity; s++) {
+        if (map->keys[s] != -1 && keep(map->values[s], data)) alive++;
+    }
+    long capacity = map->capacity;
+    while (2 * alive >= capacity / 2) { capacity *= 2; }
+    rebuild(map, capacity, keep, data);
+}
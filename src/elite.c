@@ -0,0 +1,180 @@
+#include "elite.h"
+
+#include <float.h>
+
+uint64_t edge_zobrist(int i, int j, int num_nodes) {
+    uint64_t z = i < j ? (uint64_t) i * num_nodes + j : (uint64_t) j * num_nodes + i;
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t tour_zobrist(const int *tour, int num_nodes) {
+    uint64_t hash = 0;
+    for (int i = 0; i < num_nodes; i++) {
+        hash ^= edge_zobrist(tour[i], tour[i + 1 < num_nodes ? i + 1 : 0], num_nodes);
+    }
+    return hash;
+}
+
+elite_pool* elite_create(int num_nodes, int capacity) {
+    elite_pool *pool = MALLOC(1, elite_pool);
+    pool->num_nodes = num_nodes;
+    pool->capacity = capacity;
+    pool->size = 0;
+    pool->tours = MALLOC(((long) capacity * num_nodes), int);
+    pool->costs = MALLOC(capacity, double);
+    pool->hashes = MALLOC(capacity, uint64_t);
+    pool->adj = MALLOC((2 * num_nodes), int);
+    pthread_mutex_init(&(pool->mutex), NULL);
+    return pool;
+}
+
+void elite_free(elite_pool *pool) {
+    if (pool == NULL) return;
+    pthread_mutex_destroy(&(pool->mutex));
+    FREE(pool->tours);
+    FREE(pool->costs);
+    FREE(pool->hashes);
+    FREE(pool->adj);
+    FREE(pool);
+}
+
+/**
+ * Counts the edges of a tour of the pool which are not in the tour stored in pool->adj
+ */
+static int tour_distance(const elite_pool *pool, const int *tour) {
+    int n = pool->num_nodes;
+    int distance = 0;
+    for (int i = 0; i < n; i++) {
+        int u = tour[i];
+        int v = tour[i + 1 < n ? i + 1 : 0];
+        if (pool->adj[2 * u] != v && pool->adj[2 * u + 1] != v) { distance++; }
+    }
+    return distance;
+}
+
+int elite_add(elite_pool *pool, const int *tour, double cost) {
+    int n = pool->num_nodes;
+    uint64_t hash = tour_zobrist(tour, n);
+    pthread_mutex_lock(&(pool->mutex));
+    for (int e = 0; e < pool->size; e++) {
+        if (pool->hashes[e] == hash && fabs(pool->costs[e] - cost) < EPS) {
+            pthread_mutex_unlock(&(pool->mutex));
+            return 0;
+        }
+    }
+
+    int slot = -1;
+    if (pool->size < pool->capacity) {
+        slot = pool->size++;
+    } else {
+        //Replace the most similar tour among the worse ones
+        for (int i = 0; i < n; i++) {
+            pool->adj[2 * tour[i]] = tour[i + 1 < n ? i + 1 : 0];
+            pool->adj[2 * tour[i] + 1] = tour[i > 0 ? i - 1 : n - 1];
+        }
+        int min_distance = n + 1;
+        for (int e = 0; e < pool->size; e++) {
+            if (pool->costs[e] <= cost + EPS) continue;
+            int distance = tour_distance(pool, &(pool->tours[(long) e * n]));
+            if (distance < min_distance) {
+                min_distance = distance;
+                slot = e;
+            }
+        }
+    }
+    if (slot >= 0) {
+        memcpy(&(pool->tours[(long) slot * n]), tour, n * sizeof(int));
+        pool->costs[slot] = cost;
+        pool->hashes[slot] = hash;
+    }
+    pthread_mutex_unlock(&(pool->mutex));
+    return slot >= 0;
+}
+
+int elite_pick(elite_pool *pool, int *tour, double *cost, rng_state *rng) {
+    int found = 0;
+    pthread_mutex_lock(&(pool->mutex));
+    if (pool->size > 0) {
+        int e = rand_choice(0, pool->size, rng);
+        memcpy(tour, &(pool->tours[(long) e * pool->num_nodes]), pool->num_nodes * sizeof(int));
+        if (cost != NULL) { *cost = pool->costs[e]; }
+        found = 1;
+    }
+    pthread_mutex_unlock(&(pool->mutex));
+    return found;
+}
+
+double elite_best(elite_pool *pool, int *tour) {
+    double best_obj = DBL_MAX;
+    pthread_mutex_lock(&(pool->mutex));
+    int best = -1;
+    for (int e = 0; e < pool->size; e++) {
+        if (pool->costs[e] < best_obj) {
+            best_obj = pool->costs[e];
+            best = e;
+        }
+    }
+    if (best >= 0 && tour != NULL) {
+        memcpy(tour, &(pool->tours[(long) best * pool->num_nodes]), pool->num_nodes * sizeof(int));
+    }
+    pthread_mutex_unlock(&(pool->mutex));
+    return best_obj;
+}
+
+double path_relinking(local_search *ls, const int *guide, int num_checkpoints, int *best_tour) {
+    int n = ls->num_nodes;
+
+    //The number of edges of the guiding tour to add
+    int distance = 0;
+    for (int p = 0; p < n; p++) {
+        int u = guide[p];
+        int v = guide[p + 1 < n ? p + 1 : 0];
+        if (ls_succ(ls, u) != v && ls_pred(ls, u) != v) { distance++; }
+    }
+    int step = distance / (num_checkpoints + 1);
+    if (step < 1) { step = 1; }
+
+    int *touched = MALLOC(n, int);  // The endpoints of the moves done so far
+    char *is_touched = CALLOC(n, char);
+    int num_touched = 0;
+    double cost = ls_tour_cost(ls);
+    double best_obj = DBL_MAX;
+    int moves = 0, checkpoints = 0;
+    for (int p = 0; p + 1 < n; p++) {
+        //The path guide[0] ... guide[p] is already in the tour. u is its last node and v must follow it
+        int u = guide[p];
+        int v = guide[p + 1];
+        if (ls_succ(ls, u) == v || ls_pred(ls, u) == v) continue;
+        int forward = p == 0 || ls_succ(ls, u) != guide[p - 1]; // The direction in which the path grows
+        int b = forward ? ls_succ(ls, u) : ls_pred(ls, u);
+        int d = forward ? ls_succ(ls, v) : ls_pred(ls, v);
+        cost += ls_2opt_move(ls, u, b, v, d); // u b ... v d  ->  u v ... b d
+        moves++;
+        int endpoints[4] = {u, b, v, d};
+        for (int h = 0; h < 4; h++) {
+            if (is_touched[endpoints[h]]) continue;
+            is_touched[endpoints[h]] = 1;
+            touched[num_touched++] = endpoints[h];
+        }
+
+        if (moves % step == 0 && checkpoints < num_checkpoints && moves < distance) {
+            //Improve the intermediate tour around all the changed edges and go back to continue the walk
+            checkpoints++;
+            for (int h = 0; h < num_touched; h++) { ls_queue_node(ls, touched[h]); }
+            int mark = ls_mark(ls);
+            double improved = cost + ls_optimize(ls);
+            if (improved < best_obj - EPS) {
+                best_obj = improved;
+                ls_store(ls, best_tour);
+            }
+            ls_undo(ls, mark);
+        }
+    }
+    ls_load(ls, guide); // Same tour. It empties the queue filled by the last moves
+    FREE(touched);
+    FREE(is_touched);
+    return best_obj;
+}
@@ -2,9 +2,15 @@
 
 #include "heuristics.h"
 #include "distutil.h"
+#include "candidates.h"
+#include "eax.h"
+#include "localsearch.h"
+#include "kdtree.h"
+#include "spacecurve.h"
 
 #include <float.h>
 #include <assert.h>
+#include <pthread.h>
 
 ////////////////////////////////////////////////////////
 ///////////////// HYPERPARAMETERS //////////////////////
@@ -13,9 +19,35 @@
 #define MUTATION_RATE 0.1 // The probability of the mutation
 #define PARENT_RATE 0.6 // The percentage of parents with respect the population. 
 //E.g. if the population size is 1000 a rate of 0.6 will result in number of parents of 600
-#define HEURISTIC_INIT_RATE 0.0 // Probability of initializing an individual with a heuristic method
-#define CROSSOVER_METHOD_RATE 0.0 // The probability of using method 1 for crossover and 1- prob for method 2
+#define HEURISTIC_INIT_RATE 0.5 // Probability of initializing an individual with a heuristic method (GRASP on the spatial index)
+#define CURVE_INIT_RATE 0.5 // Probability of initializing an individual with the order of a randomly rotated and shifted space-filling curve
+#define INIT_LOCAL_SEARCH 1 // Whether the initial individuals are improved with local search
+#define INIT_TIME_RATE 0.1 // The fraction of the time limit for the initialization. When it is exceeded the remaining individuals are curve tours without local search
+#define INIT_MAX_RETRIES 5 // The number of attempts to generate an individual whose tour is not already in the population
+#define CROSSOVER_METHOD CROSSOVER_CLASSIC // The crossover used to generate the offsprings. CROSSOVER_CLASSIC or CROSSOVER_EAX. EAX is off unless it is set here
+#define CROSSOVER_METHOD_RATE 0.0 // The probability of using method 1 for crossover and 1- prob for method 2 in the classic crossover
+#define EAX_TRIALS 10 // The number of AB-cycles tried by EAX for each offspring. The best offspring is kept
 #define TWO_OPT_MUTATION_PROB 0.00 // The probability that the mutation is a 2opt
+#define SELECTION_METHOD SELECTION_TOURNAMENT // The selection of parents and survivors. SELECTION_TOURNAMENT or SELECTION_ROULETTE
+#define TOURNAMENT_SIZE 3 // The number of individuals which compete in each tournament
+#define ELITE_RATE 0.1 // With tournament selection, the fraction of the population made of the best individuals, which always survive
+#define MEMETIC_RATE 0.0 // The probability that an offspring is improved with local search. 1.0 turns the genetic algorithm into a memetic algorithm
+#define MIN_ISLAND_SIZE 50 // The minimum population size of an island. The population is split among the islands
+#define MIGRATION_INTERVAL 50 // The number of generations between two migrations
+#define NUM_MIGRANTS 2 // The number of best individuals that each island sends to another island during a migration
+#define MIGRATION_TOPOLOGY MIGRATION_RING // The way the islands are connected. MIGRATION_RING or MIGRATION_RANDOM
+
+// The crossover methods
+#define CROSSOVER_CLASSIC 0 // One-point crossover or order crossover
+#define CROSSOVER_EAX 1 // Edge assembly crossover
+
+// The selection methods
+#define SELECTION_TOURNAMENT 0 // Tournaments among random individuals, O(N) for each generation
+#define SELECTION_ROULETTE 1 // Rank based roulette wheel, O(N log N) for each generation
+
+// The topologies of the island model
+#define MIGRATION_RING 0 // Island i sends its migrants to island i + 1
+#define MIGRATION_RANDOM 1 // Each island sends its migrants to a random island
 
 // This struct represents an individual in the population. 
 // Stores the chromosome and the fitness value. 
@@ -24,6 +56,92 @@ typedef struct {
     double fitness;
 } individual;
 
+// The memory used by the genetic algorithm. It is allocated once at the beginning and reused by every generation,
+// so the generation loop does not allocate memory
+typedef struct {
+    int num_nodes;
+    int pop_size;
+    int off_size;
+    int *genes;                 // The chromosomes of all the individuals stored in a single block of (pop_size + off_size) * num_nodes genes
+    individual *individuals;    // The first pop_size individuals are the population, the following off_size are the offsprings
+    int *parents;               // The indexes of the parents in the population
+    unsigned int *node_marks;   // Visited flags of the nodes used by the crossover. A node is visited when its mark is equal to node_stamp
+    unsigned int node_stamp;
+    unsigned int *ind_marks;    // Selection flags of the individuals. An individual is selected when its mark is equal to ind_stamp
+    unsigned int ind_stamp;
+    eax_workspace *eax;         // The memory of the edge assembly crossover. NULL when it is not used
+    local_search *ls;           // The local search used by the memetic algorithm and the 2opt mutation. NULL when it is not used
+    edge *grasp_edges;          // The solution written by GRASP in the initialization. NULL when it is not used
+} ga_arena;
+
+/**
+ * Allocates the memory of the genetic algorithm
+ * 
+ * @param inst The problem instance
+ * @param pop_size The size of the population
+ * @param off_size The number of offsprings generated in each generation
+ * @returns The allocated arena
+ */
+static ga_arena* arena_create(instance *inst, int pop_size, int off_size) {
+    int num_nodes = inst->num_nodes;
+    ga_arena *arena = MALLOC(1, ga_arena);
+    int N = pop_size + off_size;
+    arena->num_nodes = num_nodes;
+    arena->pop_size = pop_size;
+    arena->off_size = off_size;
+    arena->genes = MALLOC((long) N * num_nodes, int);
+    arena->individuals = MALLOC(N, individual);
+    for (int i = 0; i < N; i++) {
+        arena->individuals[i].chromosome = &(arena->genes[(long) i * num_nodes]);
+        arena->individuals[i].fitness = DBL_MAX;
+    }
+    arena->parents = MALLOC(off_size, int);
+    arena->node_marks = CALLOC(num_nodes, unsigned int);
+    arena->node_stamp = 0;
+    arena->ind_marks = CALLOC(N, unsigned int);
+    arena->ind_stamp = 0;
+    arena->eax = CROSSOVER_METHOD == CROSSOVER_EAX ? eax_create(num_nodes) : NULL;
+    arena->ls = MEMETIC_RATE > 0 || TWO_OPT_MUTATION_PROB > 0 || INIT_LOCAL_SEARCH ? ls_create(inst) : NULL;
+    arena->grasp_edges = HEURISTIC_INIT_RATE > 0 ? MALLOC(num_nodes, edge) : NULL;
+    return arena;
+}
+
+/**
+ * Releases the memory of the genetic algorithm
+ * 
+ * @param arena The arena to free
+ */
+static void arena_free(ga_arena *arena) {
+    if (arena == NULL) return;
+    FREE(arena->genes);
+    FREE(arena->individuals);
+    FREE(arena->parents);
+    FREE(arena->node_marks);
+    FREE(arena->ind_marks);
+    eax_free(arena->eax);
+    ls_free(arena->ls);
+    FREE(arena->grasp_edges);
+    FREE(arena);
+}
+
+/**
+ * Gives a new stamp so that all the marks are considered not set without clearing the array.
+ * The array is cleared only when the stamp overflows
+ * 
+ * @param marks The marks array
+ * @param size The size of the marks array
+ * @param stamp The reference of the current stamp
+ * @returns The new stamp
+ */
+static unsigned int next_stamp(unsigned int *marks, int size, unsigned int *stamp) {
+    (*stamp)++;
+    if (*stamp == 0) {
+        memset(marks, 0, size * sizeof(unsigned int));
+        *stamp = 1;
+    }
+    return *stamp;
+}
+
 /**
  * Transforms the chromosome representation to edge representation
  * 
@@ -63,44 +181,96 @@ static int compare_individuals(const void *lhs, const void *rhs) {
     const individual* lp = lhs;
     const individual* rp = rhs;
 
-    return rp->fitness - lp->fitness;
+    // Decreasing fitness: the best individual is the last one. The fitness difference is not returned 
+    // since its truncation to int would consider equal the individuals which differ by less than 1
+    return (lp->fitness < rp->fitness) - (lp->fitness > rp->fitness);
     
 }
 
+/**
+ * Rearranges the individuals so that the k best ones (i.e. with the lowest fitness) are in the first k positions
+ * in any order. It is the quickselect algorithm, O(N) on average
+ * 
+ * @param individuals The individuals to rearrange
+ * @param N The number of individuals
+ * @param k The number of best individuals to move in front
+ * @param rng The random generator used to choose the pivots
+ */
+static void select_best(individual *individuals, int N, int k, rng_state *rng) {
+    int lo = 0, hi = N - 1;
+    while (lo < hi && k > lo && k <= hi) {
+        double pivot = individuals[rand_choice(lo, hi + 1, rng)].fitness;
+        // Three way partition: [lo, lt) < pivot, [lt, gt] == pivot, (gt, hi] > pivot
+        int lt = lo, i = lo, gt = hi;
+        while (i <= gt) {
+            individual tmp = individuals[i];
+            if (tmp.fitness < pivot) {
+                individuals[i++] = individuals[lt];
+                individuals[lt++] = tmp;
+            } else if (tmp.fitness > pivot) {
+                individuals[i] = individuals[gt];
+                individuals[gt--] = tmp;
+            } else {
+                i++;
+            }
+        }
+        if (k < lt) { hi = lt - 1; }
+        else if (k > gt + 1) { lo = gt + 1; }
+        else { return; }
+    }
+}
 
 /**
- * Picks from the population a random number of individuals which are going to be the parents to produce offsprings
+ * Picks the best individual among TOURNAMENT_SIZE random individuals in [from, to) which are not marked
  * 
- * @param parents A reference of the parents array
- * @param parent_size The number of parents (i.e. capacity of parents array)
- * @param pop_size The current number of individuals in the population
+ * @param individuals The individuals
+ * @param from The first index of the individuals which can compete
+ * @param to The index after the last individual which can compete
+ * @param marks The marks of the individuals. The individuals whose mark is equal to stamp cannot compete
+ * @param stamp The current stamp
+ * @param rng The random generator
+ * @returns The index of the winner
  */
-void select_parents(individual* population, int* parents, const int parent_size, const int pop_size) {
-    MEMSET(parents, -1, parent_size, int);
+static int tournament(const individual *individuals, int from, int to, const unsigned int *marks, unsigned int stamp, rng_state *rng) {
+    int winner = -1;
+    for (int t = 0; t < TOURNAMENT_SIZE; t++) {
+        int index = rand_choice(from, to, rng);
+        while (marks[index] == stamp) { index = index + 1 < to ? index + 1 : from; } // The next free individual
+        if (winner < 0 || individuals[index].fitness < individuals[winner].fitness) { winner = index; }
+    }
+    return winner;
+}
+
+
+/**
+ * Picks the parents with rank based roulette wheel selection. The parents are stored in the parents array of the arena
+ * 
+ * @param arena The memory of the genetic algorithm which contains the population
+ * @param rng The random generator used for the selection
+ */
+static void roulette_parents(ga_arena *arena, rng_state *rng) {
+    individual *population = arena->individuals;
+    int *parents = arena->parents;
+    const int parent_size = arena->off_size;
+    const int pop_size = arena->pop_size;
     int count = 0;
 
-    int* visited = CALLOC(pop_size, int);
+    unsigned int *visited = arena->ind_marks;
+    unsigned int stamp = next_stamp(visited, pop_size + arena->off_size, &(arena->ind_stamp));
 
     // Rank based roulette wheel selection. Check this paper here: http://www.iaeng.org/publication/WCE2011/WCE2011_pp1134-1139.pdf
 
     // Ranking the fitnessess using qsort. Best fitness will be displaced at the end so it will have the highest rank
     qsort(population, pop_size, sizeof(individual), compare_individuals);
 
-    // Calculating the cumulative sum. This is part of wheel selection.   
-    double rank_sum = pop_size * (pop_size + 1) / 2;
-    double* cum_sum = CALLOC(pop_size, double);
-
-    cum_sum[0] = 1;
-    for (int i = 1; i < pop_size; i++) {
-        double sum = cum_sum[i - 1] + i + 1;
-        cum_sum[i] = sum;
-    }
+    // The cumulative sum of the ranks is 1, 3, 6, 10, ... so it is not stored. This is part of wheel selection.
+    double rank_sum = (double) pop_size * (pop_size + 1) / 2;
 
 
     while (count < parent_size) {
 
         // Choosing the individual based on it's cumulative sum (i.e. such as probability). Part of wheel selection
-        double random_num = rand_choice(1, rank_sum);
+        double random_num = rand_choice(1, rank_sum, rng);
 
         // This formula is Gauss' sum reversed formula n*(n+1) / 2 = m. When we set m as the random_num,
         // we can obtain n using this equation n^2 + n - 2*m = 0. The result of the equation returns the
@@ -113,53 +283,87 @@ void select_parents(individual* population, int* parents, const int parent_size,
         // starts from 0, in the position 5 we have the number 21 which is the nearest greater number from 18. 
         int index = (-1 + sqrt(1 + 8*random_num)) / 2.0; // Returns the index of the first higher number of random num. It must be a ceil operation
 
-        // Example [1,3,6,10,15,21,28,36,45]. If rand_num is 18, the first_bigger_value is 21 and the 
-        // last_smaller_value is 15
-        double first_bigger_value = cum_sum[index]; // The first biggest number from rand_num
-        double last_smaller_value = cum_sum[index - 1]; // The last smaller number from rand_num
-        //assert(random_num < first_bigger_value);
-        //assert(random_num >= last_smaller_value);
         // Looking for the next not visited individual
-        while (index < pop_size - 1 && visited[index]) { index++; }
-        if (!visited[index]) {
+        while (index < pop_size - 1 && visited[index] == stamp) { index++; }
+        if (visited[index] != stamp) {
             parents[count++] = index;
-            visited[index] = 1;
+            visited[index] = stamp;
         }
     }
-    FREE(cum_sum);
-    FREE(visited);
-    
 }
 
 /**
- * Applies the crossover phase of the genetic algorithm. From two parents an offspring is generated.
+ * Picks the parents with tournaments among individuals which are not parents yet. 
+ * The parents are stored in the parents array of the arena
+ * 
+ * @param arena The memory of the genetic algorithm which contains the population
+ * @param rng The random generator used for the selection
+ */
+static void tournament_parents(ga_arena *arena, rng_state *rng) {
+    unsigned int *chosen = arena->ind_marks;
+    unsigned int stamp = next_stamp(chosen, arena->pop_size + arena->off_size, &(arena->ind_stamp));
+    for (int count = 0; count < arena->off_size; count++) {
+        int winner = tournament(arena->individuals, 0, arena->pop_size, chosen, stamp, rng);
+        chosen[winner] = stamp;
+        arena->parents[count] = winner;
+    }
+}
+
+/**
+ * Picks from the population a random number of individuals which are going to be the parents to produce offsprings.
+ * The parents are stored in the parents array of the arena
+ * 
+ * @param arena The memory of the genetic algorithm which contains the population
+ * @param rng The random generator used for the selection
+ */
+void select_parents(ga_arena *arena, rng_state *rng) {
+    if (SELECTION_METHOD == SELECTION_ROULETTE) {
+        roulette_parents(arena, rng);
+    } else {
+        tournament_parents(arena, rng);
+    }
+}
+
+/**
+ * Applies the crossover phase of the genetic algorithm. From two parents an offspring is generated and evaluated.
+ * The crossover is chosen at compile time by CROSSOVER_METHOD: the classic crossover by default, EAX only when
+ * CROSSOVER_METHOD is CROSSOVER_EAX
  * 
  * @param inst The problem instance
- * @param population The list of individuals which composes the population
+ * @param arena The memory of the genetic algorithm
  * @param parent1 The index of the first parent in the population
  * @param parent2 The index of the second parent in the population
- * @param chromosome The offspring's chromosome that is generated from the two parents.
+ * @param offspring The offspring that is generated from the two parents. Its fitness is set too
+ * @param rng The random generator used for the crossover
  */
-void crossover(instance* inst, const individual *population, const int parent1, const int parent2, int* chromosome) {
-    individual p1 = population[parent1];
-    individual p2 = population[parent2];
+void crossover(instance* inst, ga_arena *arena, const int parent1, const int parent2, individual *offspring, rng_state *rng) {
+    individual p1 = arena->individuals[parent1];
+    individual p2 = arena->individuals[parent2];
+    int *chromosome = offspring->chromosome;
+
+    if (CROSSOVER_METHOD == CROSSOVER_EAX) {
+        // Edge assembly crossover. The offspring inherits almost all its edges from the parents and EAX gives its cost
+        offspring->fitness = eax_crossover(inst, arena->eax, p1.chromosome, p1.fitness, p2.chromosome, chromosome, EAX_TRIALS, rng);
+        return;
+    }
 
-    int *visited = CALLOC(inst->num_nodes, int);
-    double rand_num = URAND();
+    unsigned int *visited = arena->node_marks;
+    unsigned int stamp = next_stamp(visited, inst->num_nodes, &(arena->node_stamp));
+    double rand_num = URAND(rng);
     if (rand_num < CROSSOVER_METHOD_RATE) {
         // Crossover method 1
         // This method takes a random index which splits the chromosome. 
-        int rand_index = rand_choice(0, inst->num_nodes);
+        int rand_index = rand_choice(0, inst->num_nodes, rng);
         int idx = 0;
         for (int i = 0; i < inst->num_nodes; i++) {
             
             if (i <= rand_index) {
                 int node = p1.chromosome[i];
-                visited[node] = 1;
+                visited[node] = stamp;
                 chromosome[idx] = node;
             } else {
                 int node = p2.chromosome[i];
-                if (visited[node]) { continue; }
+                if (visited[node] == stamp) { continue; }
                 chromosome[idx] = node;
             }
             idx++;
@@ -168,7 +372,7 @@ void crossover(instance* inst, const individual *population, const int parent1,
         if (idx < inst->num_nodes) {
             for (int i = 0; i <= rand_index; i++) {
                 int node = p2.chromosome[i];
-                if (visited[node]) { continue; }
+                if (visited[node] == stamp) { continue; }
                 chromosome[idx++] = node;
             }
         }
@@ -178,8 +382,8 @@ void crossover(instance* inst, const individual *population, const int parent1,
         // This substring is going to be added in the same position of offspring's chromosome. The remaining offspring's chromosome positions are
         // going to be filled by the remaining nodes in parent's 2 chromosome in order of appearing from rand_index2. 
         // Here's an image which describes this procedure: https://miro.medium.com/max/1458/1*YhmzBBCyAG3rtEBbI0gz4w.jpeg
-        int rand_index1 = rand_choice(0, inst->num_nodes);
-        int rand_index2 = rand_choice(0, inst->num_nodes);
+        int rand_index1 = rand_choice(0, inst->num_nodes, rng);
+        int rand_index2 = rand_choice(0, inst->num_nodes, rng);
         if (rand_index1 > rand_index2) {
             int tmp = rand_index1;
             rand_index1 = rand_index2;
@@ -196,7 +400,7 @@ void crossover(instance* inst, const individual *population, const int parent1,
         int nodes_added = 0;
         for (int i = rand_index1; i <= rand_index2; i++) {
             int node = p1.chromosome[i];
-            visited[node] = 1;
+            visited[node] = stamp;
             chromosome[i] = node;
             nodes_added++;
         }
@@ -212,7 +416,7 @@ void crossover(instance* inst, const individual *population, const int parent1,
         while (nodes_added < inst->num_nodes) {
             int p2_index = parent2_counter % inst->num_nodes; // Getting the current looking gene on parent2's chromosome.
             int node = p2.chromosome[p2_index];
-            if (!visited[node]) {
+            if (visited[node] != stamp) {
                 int offspring_index = offspring_crom_counter % inst->num_nodes; // Gettings the current index of offspring's chromosome where the new entry will be added
                 chromosome[offspring_index] = node;
                 nodes_added++;
@@ -222,98 +426,90 @@ void crossover(instance* inst, const individual *population, const int parent1,
             parent2_counter++;
         }
     }
-
-    FREE(visited);
+    fitness(inst, offspring);
 }
 
 /**
  * Does the procreation phase where the parents generate new offsprings.
+ * The offsprings are written directly in the offspring slots of the arena.
  * 
  * @param inst The problem instance
- * @param population The list of individuals which composes the population
- * @param parents The list of indexes of the parents in the population
- * @param parent_size The size of the parents array
- * @param offsprings The list of offsprings generated
+ * @param arena The memory of the genetic algorithm which contains the population and the parents
+ * @param rng The random generator used for the crossover
  */
-void procreate(instance* inst, const individual *population, const int* parents, const int parent_size, individual* offsprings) {
-    
-    int* chromosome = CALLOC(inst->num_nodes, int);
-    int counter = 0;
+void procreate(instance* inst, ga_arena *arena, rng_state *rng) {
+    const int parent_size = arena->off_size;
+    individual *offsprings = &(arena->individuals[arena->pop_size]);
 
     for (int i = 0; i < parent_size; i++) {
         int j = (i + 1) % parent_size;
-        int parent1 = parents[i];
-        int parent2 = parents[j];
-        crossover(inst, population, parent1, parent2, chromosome);
-        memcpy(offsprings[counter].chromosome, chromosome, sizeof(int) * inst->num_nodes);
-        fitness(inst, &(offsprings[counter]));
-
-        counter++;
+        int parent1 = arena->parents[i];
+        int parent2 = arena->parents[j];
+        crossover(inst, arena, parent1, parent2, &(offsprings[i]), rng);
     }
-    FREE(chromosome);
 }
 
 /**
  * Choses the best performing individuals. Sometimes to mantain diversification,
  * a random individual is also selected reghardless its fitness function with a probability of 10%. 
+ * The survivors are moved at the beginning of the arena by swapping the individuals, so the chromosomes are 
+ * never copied. The chromosomes of the discarded individuals are reused by the offsprings of the next generation.
  * 
- * @param inst The problem instance
- * @param population The list of individuals which composes the population
- * @param pop_size The current number of individuals in the population
- * @param offsrpings The offsprings list
- * @param off_size The capacity of offsprings
+ * With tournament selection the best ELITE_RATE of the population survives, found in O(N) with quickselect, 
+ * and the other survivors win a tournament. With roulette selection the survivors are chosen with rank based 
+ * roulette wheel selection.
+ * 
+ * @param arena The memory of the genetic algorithm which contains the population and the offsprings
+ * @param rng The random generator used for the selection
  */
-void choose_survivors(instance* inst, individual* population, const int pop_size, const individual* offsprings, const int off_size) {
+void choose_survivors(ga_arena *arena, rng_state *rng) {
     
-    int N = pop_size + off_size;
-    individual* total = CALLOC(N, individual);
-    int *visited = CALLOC(N, int);
+    const int pop_size = arena->pop_size;
+    const int N = pop_size + arena->off_size;
+    individual* total = arena->individuals;
+    unsigned int *visited = arena->ind_marks;
+    unsigned int stamp = next_stamp(visited, N, &(arena->ind_stamp));
     int count = 0;
-    
-    for (int i = 0; i < off_size; i++) {
-        total[count++] = offsprings[i];
-    }
-    for (int i = 0; i < pop_size; i++) {
-        total[count++] = population[i];
-    }
 
-    count = 0;
-
-    // Rank based roulette wheel selection
-    qsort(total, N, sizeof(individual), compare_individuals);
+    if (SELECTION_METHOD == SELECTION_TOURNAMENT) {
+        int elite = (int) (pop_size * ELITE_RATE);
+        select_best(total, N, elite, rng);
+        for (count = 0; count < elite; count++) { visited[count] = stamp; }
+        while (count < pop_size) {
+            int winner = tournament(total, elite, N, visited, stamp, rng);
+            visited[winner] = stamp;
+            count++;
+        }
+    } else {
 
-    double rank_sum = N * (N + 1) / 2;
+        // Rank based roulette wheel selection
+        qsort(total, N, sizeof(individual), compare_individuals);
 
-    // Cum sum can be completely removed. It's values are used only for checking whether the index chosen
-    // is correct. The correctness anyway is proved so optionally the cum sum array can be deleted
-    double* cum_sum = CALLOC(N, double);
-    cum_sum[0] = 1;
-    for (int i = 1; i < N; i++) {
-        double sum = cum_sum[i - 1] + i + 1;
-        cum_sum[i] = sum;
-    }
+        double rank_sum = (double) N * (N + 1) / 2;
 
-    while (count < pop_size) {
-        double random_num = rand_choice(1, rank_sum);
+        while (count < pop_size) {
+            double random_num = rand_choice(1, rank_sum, rng);
 
-        // To understand this, go read the same piece of code in select_parents function
-        int index = (-1 + sqrt(1 + 8 * random_num)) / 2.0;
-        double first_bigger_value = cum_sum[index]; // The first biggest number from rand_num
-        double last_smaller_value = cum_sum[index - 1]; // The last smaller number from rand_num
-        //assert(random_num < first_bigger_value);
-        //assert(random_num >= last_smaller_value);
-        // Looking for the next not visited individual
-        while (index < N - 1 && visited[index]) { index++; }
-        if (!visited[index]) {
-            memcpy(population[count].chromosome, total[index].chromosome, sizeof(int) * inst->num_nodes);
-            population[count].fitness = total[index].fitness;
-            count++;
-            visited[index] = 1;
+            // To understand this, go read the same piece of code in roulette_parents function
+            int index = (-1 + sqrt(1 + 8 * random_num)) / 2.0;
+            // Looking for the next not visited individual
+            while (index < N - 1 && visited[index] == stamp) { index++; }
+            if (visited[index] != stamp) {
+                count++;
+                visited[index] = stamp;
+            }
         }
     }
-    FREE(total);
-    FREE(visited);
-    FREE(cum_sum);
+
+    // Moving the survivors in the population slots
+    int front = 0;
+    for (int i = 0; i < N; i++) {
+        if (visited[i] != stamp) continue;
+        individual tmp = total[front];
+        total[front] = total[i];
+        total[i] = tmp;
+        front++;
+    }
 }
 
 /**
@@ -345,8 +541,9 @@ void fitness_metrics(const individual* population, const int pop_size, double* b
  * 
  * @param chromosome Where the random tour will be stored. It must have the size equal to num_nodes
  * @param num_nodes The number of nodes in the instance
+ * @param rng The random generator used to shuffle the tour
  */
-void random_generation(int* chromosome, const int num_nodes) {
+void random_generation(int* chromosome, const int num_nodes, rng_state *rng) {
     //Initialize the list of nodes with the numbers 1 to N
     for (int i = 0; i < num_nodes; i++) {  
         chromosome[i] = i;
@@ -354,8 +551,8 @@ void random_generation(int* chromosome, const int num_nodes) {
 
     //Choose randomly 2 nodes in the tour and swap them
     for (int i = 0; i < num_nodes; i++) {  
-        int idx1 = rand_choice(0, num_nodes);
-        int idx2 = rand_choice(0, num_nodes);
+        int idx1 = rand_choice(0, num_nodes, rng);
+        int idx2 = rand_choice(0, num_nodes, rng);
 
         int tmp = chromosome[idx1];
         chromosome[idx1] = chromosome[idx2];
@@ -364,43 +561,40 @@ void random_generation(int* chromosome, const int num_nodes) {
 }
 
 /**
- * The mutation phase is applied 
- * with a probability of 5%. With probability of 98% during the mutation phase, is applied a mutation where a random subtour
- * is chosen and reversed; in the remaining 2% is applied a 2-opt refinement. This 2-opt refinement works for only
- * 5 seconds. The completion of the 2-opt in this phase is not necessary. The 2-opt ideally is going to work better as the 
- * algorithm goes forward. In a very later generation, there would be low crossing edges so the 2-opt algorithm can 
- * complete under 5 seconds and return a better individual. In any case, even when the 2-opt does not complete, a better
- * individual is found because some crossing edges are removed.
+ * Improves the chromosome of an individual with 2-opt and Or-opt moves on the candidate lists.
+ * The local search works in place on the chromosome and the fitness is updated with the cost change of the moves
+ * 
+ * @param ls The local search of the island
+ * @param individual The individual to improve
  */
-void mutation(instance* inst, individual* offsprings, const int off_size) {
+static void local_search_individual(local_search *ls, individual *individual) {
+    ls_load(ls, individual->chromosome);
+    ls_queue_all(ls);
+    individual->fitness += ls_optimize(ls);
+    ls_store(ls, individual->chromosome);
+}
+
+/**
+ * The mutation phase is applied to each offspring with probability MUTATION_RATE. With probability 1 - TWO_OPT_MUTATION_PROB
+ * the mutation chooses a random subtour and reverses it; otherwise it is a 2-opt refinement. The reversal changes only two edges, so 
+ * the fitness is updated in O(1). The 2-opt refinement is the local search on the candidate lists, which works in place
+ * on the chromosome.
+ */
+void mutation(instance* inst, ga_arena *arena, rng_state *rng) {
+    individual *offsprings = &(arena->individuals[arena->pop_size]);
+    const int off_size = arena->off_size;
+    const int n = inst->num_nodes;
     for (int off = 0; off < off_size; off++) {
 
-        double rand_mut = URAND() ;
+        double rand_mut = URAND(rng);
         // Mutation phase
         if (rand_mut < MUTATION_RATE) {
-            // Mutation method 1
-            // It takes two nodes and swaps them
-            /*int rand_index1 = rand_choice(0, inst->num_nodes - 1);
-            int rand_index2 = rand_choice(0, inst->num_nodes - 1);
-            if (rand_index1 == rand_index2) {
-                // Dont' assign manually. Just for test
-                if (rand_index1 < inst->num_nodes - 1) {
-                    rand_index2 = rand_index1 + 1;
-                } else {
-                    rand_index2 = rand_index1 - 1;
-                }
-                
-            }
-            int temp = population[count].chromosome[rand_index1];
-            population[count].chromosome[rand_index1] = population[count].chromosome[rand_index2];
-            population[count].chromosome[rand_index2] = temp;
-            fitness(inst, &(population[count]));*/
-            double rand_method = URAND();
+            double rand_method = URAND(rng);
             if (rand_method > TWO_OPT_MUTATION_PROB) {
                 // Mutation method 2
                 // It takes a subtour and reverses it. e.g. 1-4-3-7-9 becomes 9-7-3-4-1
-                int rand_index1 = rand_choice(0, inst->num_nodes - 1);
-                int rand_index2 = rand_choice(0, inst->num_nodes - 1);
+                int rand_index1 = rand_choice(0, inst->num_nodes - 1, rng);
+                int rand_index2 = rand_choice(0, inst->num_nodes - 1, rng);
                 if (rand_index1 > rand_index2) {
                     int tmp = rand_index1;
                     rand_index1 = rand_index2;
@@ -413,94 +607,328 @@ void mutation(instance* inst, individual* offsprings, const int off_size) {
                         rand_index2 += 1;
                     }
                 }
-                int tot_iter = rand_index2 - rand_index1;
+                int *chromosome = offsprings[off].chromosome;
+
+                // Only the edges entering and leaving the reversed subtour change
+                int prev = chromosome[(rand_index1 - 1 + n) % n];
+                int next = chromosome[(rand_index2 + 1) % n];
+                offsprings[off].fitness += calc_dist(prev, chromosome[rand_index2], inst) + calc_dist(chromosome[rand_index1], next, inst)
+                                         - calc_dist(prev, chromosome[rand_index1], inst) - calc_dist(chromosome[rand_index2], next, inst);
+
                 int incr_idx = rand_index1;
                 int decr_idx = rand_index2;
-                for (int i = 0; i < tot_iter / 2; i++) {
-                    int tmp = offsprings[off].chromosome[incr_idx];
-                    offsprings[off].chromosome[incr_idx] = offsprings[off].chromosome[decr_idx];
-                    offsprings[off].chromosome[decr_idx] = tmp;
+                while (incr_idx < decr_idx) {
+                    int tmp = chromosome[incr_idx];
+                    chromosome[incr_idx] = chromosome[decr_idx];
+                    chromosome[decr_idx] = tmp;
                     incr_idx++;
                     decr_idx--;
                 }
             } else {
                 // Mutation method3
                 // Applies 2opt algoritm.
-                //LOG_D("Applying 2opt mutation");
-                instance tmp_inst;
-                copy_instance(&tmp_inst, inst);
-                from_chromosome_to_edges(&tmp_inst, offsprings[off]);
-                // We set 2opt's time limit so it finishes faster and finds a little better solution 
-                tmp_inst.params.time_limit = 2;
-                alg_2opt(&tmp_inst);
-                int node_idx = 0;
-                int node_iter = 0;
-                while (node_iter < tmp_inst.num_nodes) {
-                    offsprings[off].chromosome[node_iter++] = tmp_inst.solution.edges[node_idx].i;
-                    node_idx = tmp_inst.solution.edges[node_idx].j;
-                }
-                free_instance(&tmp_inst);
+                local_search_individual(arena->ls, &(offsprings[off]));
             }
         }
     }
 }
 
-int HEU_Genetic(instance *inst) {
-    int status = 0;
+/**
+ * The memetic phase. Each offspring is improved with local search with probability MEMETIC_RATE 
+ * 
+ * @param arena The memory of the genetic algorithm
+ * @param rng The random generator
+ */
+void improve_offsprings(ga_arena *arena, rng_state *rng) {
+    if (MEMETIC_RATE <= 0) return;
+    individual *offsprings = &(arena->individuals[arena->pop_size]);
+    for (int off = 0; off < arena->off_size; off++) {
+        if (URAND(rng) < MEMETIC_RATE) {
+            local_search_individual(arena->ls, &(offsprings[off]));
+        }
+    }
+}
 
-    //Start counting time from now
-    struct timeval start, end;
-    gettimeofday(&start, 0);
+// Data shared by the islands of the genetic algorithm
+typedef struct {
+    instance *inst;
+    int num_islands;
+    int time_limit;
+    struct timeval start;
+    pthread_mutex_t mutex;      // Protects the migration buffers and the incumbent solution
+    int *migrant_genes;         // The chromosomes waiting to enter each island: NUM_MIGRANTS chromosomes per island
+    double *migrant_fitness;    // The fitness of the waiting chromosomes
+    int *num_migrants;          // The number of chromosomes waiting to enter each island
+    double incumbent;           // The best fitness found by all the islands. Its tour is stored in inst->solution
+    instance scratch;           // A copy of the instance taken before the islands start. It shares the problem data and has no solution
+} ga_shared;
+
+// An island of the genetic algorithm. Each island evolves its own population in its own thread
+typedef struct {
+    ga_shared *shared;
+    int id;
+    int pop_size;
+    rng_state rng;              // The random stream of the island
+    unsigned int generations;   // The number of generations done by the island
+    int status;
+} ga_island;
 
-    const int pop_size = POPULATION_SIZE; // Population size
-    individual *population = CALLOC(pop_size, individual);//Allocate pupulation
+/**
+ * Sends the best individuals of the island to the destination island. 
+ * The previous migrants which have not entered the destination yet are replaced.
+ * 
+ * @param island The island which sends the migrants
+ * @param arena The memory of the island
+ */
+static void emigrate(ga_island *island, ga_arena *arena) {
+    ga_shared *shared = island->shared;
+    int n = arena->num_nodes;
+    int dest = (island->id + 1) % shared->num_islands;
+    if (MIGRATION_TOPOLOGY == MIGRATION_RANDOM) {
+        dest = rand_choice(0, shared->num_islands - 1, &(island->rng));
+        if (dest >= island->id) dest++; // An island does not send migrants to itself
+    }
 
-    // Generate Initial population
-    for (int i = 0; i < pop_size; i++) {
-        population[i].chromosome = CALLOC(inst->num_nodes, int);
-
-        double rand_num = URAND();
-        if (rand_num < HEURISTIC_INIT_RATE) {
-            int start_node = rand_choice(0, inst->num_nodes);
-            grasp(inst, start_node);
-                
-            int node_idx = start_node;
-            int node_iter = 0;
-            while (node_iter < inst->num_nodes) {
-                population[i].chromosome[node_iter++] = inst->solution.edges[node_idx].i;
-                node_idx = inst->solution.edges[node_idx].j;
-            }
-        } else {
-            //generate a single individual
-            random_generation(population[i].chromosome, inst->num_nodes);
+    // The NUM_MIGRANTS best individuals are found with repeated scans since they are very few
+    unsigned int *chosen = arena->ind_marks;
+    unsigned int stamp = next_stamp(chosen, arena->pop_size + arena->off_size, &(arena->ind_stamp));
+    pthread_mutex_lock(&(shared->mutex));
+    int count = 0;
+    for (int m = 0; m < NUM_MIGRANTS && m < arena->pop_size; m++) {
+        int best = -1;
+        for (int i = 0; i < arena->pop_size; i++) {
+            if (chosen[i] == stamp) continue;
+            if (best < 0 || arena->individuals[i].fitness < arena->individuals[best].fitness) { best = i; }
         }
-        
-        
+        chosen[best] = stamp;
+        long slot = (long) dest * NUM_MIGRANTS + count;
+        memcpy(&(shared->migrant_genes[slot * n]), arena->individuals[best].chromosome, n * sizeof(int));
+        shared->migrant_fitness[slot] = arena->individuals[best].fitness;
+        count++;
+    }
+    shared->num_migrants[dest] = count;
+    pthread_mutex_unlock(&(shared->mutex));
+}
 
-        //Evaluate the fitness of this individual
-        fitness(inst, &(population[i]));
+/**
+ * Moves the migrants waiting for the island into its population. Each migrant replaces the worst individual
+ * of the population when it is better
+ * 
+ * @param island The island which receives the migrants
+ * @param arena The memory of the island
+ */
+static void immigrate(ga_island *island, ga_arena *arena) {
+    ga_shared *shared = island->shared;
+    int n = arena->num_nodes;
+    pthread_mutex_lock(&(shared->mutex));
+    for (int m = 0; m < shared->num_migrants[island->id]; m++) {
+        int worst = 0;
+        for (int i = 1; i < arena->pop_size; i++) {
+            if (arena->individuals[i].fitness > arena->individuals[worst].fitness) { worst = i; }
+        }
+        long slot = (long) island->id * NUM_MIGRANTS + m;
+        if (shared->migrant_fitness[slot] >= arena->individuals[worst].fitness) continue;
+        memcpy(arena->individuals[worst].chromosome, &(shared->migrant_genes[slot * n]), n * sizeof(int));
+        arena->individuals[worst].fitness = shared->migrant_fitness[slot];
+    }
+    shared->num_migrants[island->id] = 0;
+    pthread_mutex_unlock(&(shared->mutex));
+}
 
+// A node with its position along a space-filling curve
+typedef struct {
+    uint64_t key;
+    int node;
+} curve_node;
+
+static int compare_curve_nodes(const void *lhs, const void *rhs) {
+    const curve_node *lp = lhs;
+    const curve_node *rp = rhs;
+    if (lp->key != rp->key) return lp->key < rp->key ? -1 : 1;
+    return lp->node - rp->node;
+}
+
+/**
+ * Generates the tour which visits the nodes in the order of a Hilbert curve over the plane randomly rotated and shifted.
+ * Different rotations and shifts give different tours of similar quality. O(n log n)
+ * 
+ * @param inst The problem instance
+ * @param chromosome Where the tour is stored
+ * @param curve Work memory of num_nodes entries
+ * @param rng The random generator used to rotate and shift the plane
+ */
+static void curve_generation(instance *inst, int* chromosome, curve_node *curve, rng_state *rng) {
+    int n = inst->num_nodes;
+    double cx = 0, cy = 0;
+    for (int i = 0; i < n; i++) {
+        cx += inst->nodes[i].x;
+        cy += inst->nodes[i].y;
     }
+    cx /= n;
+    cy /= n;
+    double radius = 0;
+    for (int i = 0; i < n; i++) {
+        radius = fmax(radius, fabs(inst->nodes[i].x - cx) + fabs(inst->nodes[i].y - cy));
+    }
+    if (radius <= 0) { radius = 1; }
+
+    double angle = 2 * PI * URAND(rng);
+    double cos_a = cos(angle), sin_a = sin(angle);
+    double shift_x = radius * URAND(rng), shift_y = radius * URAND(rng);
+    double scale = ((1u << 16) - 1) / (3 * radius); // The rotated and shifted nodes are in [0, 3 * radius)
+    for (int i = 0; i < n; i++) {
+        double x = inst->nodes[i].x - cx, y = inst->nodes[i].y - cy;
+        double rx = cos_a * x - sin_a * y + radius + shift_x;
+        double ry = sin_a * x + cos_a * y + radius + shift_y;
+        curve[i].key = hilbert_index((uint32_t) (rx * scale), (uint32_t) (ry * scale), 16);
+        curve[i].node = i;
+    }
+    qsort(curve, n, sizeof(curve_node), compare_curve_nodes);
+    for (int i = 0; i < n; i++) { chromosome[i] = curve[i].node; }
+}
 
-    //Set time limit
-    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {
-        LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);
+/**
+ * Computes a hash of the edges of a tour. The hash does not depend on the starting node and on the direction of the tour
+ * 
+ * @param chromosome The tour
+ * @param num_nodes The number of nodes
+ * @returns The hash of the tour. It is never 0
+ */
+static uint64_t tour_hash(const int *chromosome, int num_nodes) {
+    uint64_t hash = 0;
+    for (int i = 0; i < num_nodes; i++) {
+        uint64_t a = chromosome[i], b = chromosome[(i + 1) % num_nodes];
+        uint64_t z = a < b ? a * num_nodes + b : b * num_nodes + a;
+        // splitmix64 finalizer. The edges' hashes are summed so their order does not matter
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        hash += z ^ (z >> 31);
     }
-    int time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
-    
-    //Allocate memory for parents and offspring
-    unsigned int generation = 1;
+    return hash != 0 ? hash : 1;
+}
+
+/**
+ * Inserts the hash of a tour in the set of the population's tours (open addressing with linear probing)
+ * 
+ * @param table The hash set. 0 means an empty slot
+ * @param size The size of the set. It must be a power of 2
+ * @param hash The hash to insert
+ * @returns 1 if the hash was inserted, 0 if it was already in the set
+ */
+static int insert_hash(uint64_t *table, int size, uint64_t hash) {
+    int slot = (int) (hash & (size - 1));
+    while (table[slot] != 0) {
+        if (table[slot] == hash) return 0;
+        slot = (slot + 1) & (size - 1);
+    }
+    table[slot] = hash;
+    return 1;
+}
+
+/**
+ * Generates the initial population of an island. The individuals are randomized space-filling curve tours, 
+ * GRASP tours built on the spatial index or random tours, improved with the local search.
+ * The tours already in the population are discarded and generated again.
+ * 
+ * @param island The island to initialize
+ * @param arena The memory of the island
+ */
+static void initialize_population(ga_island *island, ga_arena *arena) {
+    ga_shared *shared = island->shared;
+    instance *inst = shared->inst;
+    rng_state *rng = &(island->rng);
+    individual *population = arena->individuals;
+    const int n = inst->num_nodes;
+    const double init_time_limit = shared->time_limit * INIT_TIME_RATE;
+
+    // GRASP writes the tour in the instance's solution, so each island runs it on a scratch copy of the instance
+    // which shares the problem data and writes in the memory of the island
+    instance scratch = shared->scratch;
+    scratch.solution.edges = arena->grasp_edges;
+    kdtree *tree = HEURISTIC_INIT_RATE > 0 ? kdtree_build(inst) : NULL;
+    curve_node *curve = MALLOC(n, curve_node);
+    int table_size = 1;
+    while (table_size < 2 * arena->pop_size) { table_size *= 2; }
+    uint64_t *hashes = CALLOC(table_size, uint64_t);
+    int duplicates = 0;
+    struct timeval now;
+
+    for (int i = 0; i < arena->pop_size; i++) {
+        if (i == 0 && island->id == 0 && inst->warm_start != NULL) {
+            //The warm start tour enters the population of the first island as it is
+            memcpy(population[i].chromosome, inst->warm_start, n * sizeof(int));
+            fitness(inst, &(population[i]));
+            insert_hash(hashes, table_size, tour_hash(population[i].chromosome, n));
+            continue;
+        }
+        gettimeofday(&now, 0);
+        int fast = get_elapsed_time(shared->start, now) > init_time_limit; // Out of time: only curve tours
+
+        for (int attempt = 0; attempt <= INIT_MAX_RETRIES; attempt++) {
+            double rand_num = URAND(rng);
+            if (!fast && rand_num < HEURISTIC_INIT_RATE) {
+                int start_node = rand_choice(0, n, rng);
+                grasp(&scratch, start_node, tree, rng);
+                    
+                int node_idx = start_node;
+                int node_iter = 0;
+                while (node_iter < n) {
+                    population[i].chromosome[node_iter++] = scratch.solution.edges[node_idx].i;
+                    node_idx = scratch.solution.edges[node_idx].j;
+                }
+            } else if (fast || rand_num < HEURISTIC_INIT_RATE + CURVE_INIT_RATE) {
+                curve_generation(inst, population[i].chromosome, curve, rng);
+            } else {
+                //generate a single individual
+                random_generation(population[i].chromosome, n, rng);
+            }
+
+            //Evaluate the fitness of this individual
+            fitness(inst, &(population[i]));
+            if (INIT_LOCAL_SEARCH && !fast) { local_search_individual(arena->ls, &(population[i])); }
+
+            if (insert_hash(hashes, table_size, tour_hash(population[i].chromosome, n))) break;
+            duplicates++;
+        }
+    }
+    if (inst->params.verbose >= 4) {
+        gettimeofday(&now, 0);
+        LOG_I("Island %d initialized in %0.2fs. Duplicated tours discarded: %d", island->id, get_elapsed_time(shared->start, now), duplicates);
+    }
+
+    FREE(hashes);
+    FREE(curve);
+    kdtree_free(tree);
+}
+
+/**
+ * Evolves the population of an island until the time limit is reached. This is the function executed by the island's thread
+ * 
+ * @param arg The pointer of the island
+ * @returns NULL
+ */
+static void* evolve_island(void *arg) {
+    ga_island *island = (ga_island*) arg;
+    ga_shared *shared = island->shared;
+    instance *inst = shared->inst;
+    rng_state *rng = &(island->rng);
+    island->status = 0;
+
+    const int pop_size = island->pop_size; // Population size
     const int parent_size = (int) (pop_size * PARENT_RATE);
-    int* parents = CALLOC(parent_size, int); // Parents indexes
     const int offspring_size = parent_size;
-    individual* offsprings = CALLOC(offspring_size, individual);
-    for (int i = 0; i < offspring_size; i++) {
-        offsprings[i].chromosome = CALLOC(inst->num_nodes, int);
-    }
+    ga_arena *arena = arena_create(inst, pop_size, offspring_size); //Allocate population, offsprings and work memory
+    individual *population = arena->individuals;
+
+    // Generate Initial population
+    initialize_population(island, arena);
+    
+    unsigned int generation = 1;
     double best_fitness = DBL_MAX;
     double mean_fitness = 0;
     int best_idx = 0;
     double incumbent = best_fitness;
+    struct timeval end;
     
 
 
@@ -508,9 +936,9 @@ int HEU_Genetic(instance *inst) {
     while (1) {
         //Check elapsed time
         gettimeofday(&end, 0);
-        double elapsed = get_elapsed_time(start, end);
-        if (elapsed > time_limit) {
-            status = TIME_LIMIT_EXCEEDED;
+        double elapsed = get_elapsed_time(shared->start, end);
+        if (elapsed > shared->time_limit) {
+            island->status = TIME_LIMIT_EXCEEDED;
             break;
         }
 
@@ -520,8 +948,14 @@ int HEU_Genetic(instance *inst) {
         if (best_fitness < incumbent) {
             incumbent = best_fitness;
             individual best_individual = population[best_idx];
-            inst->solution.obj_best = best_fitness;
-            from_chromosome_to_edges(inst, best_individual); //Update best solution
+            pthread_mutex_lock(&(shared->mutex));
+            if (best_fitness < shared->incumbent) {
+                shared->incumbent = best_fitness;
+                inst->solution.obj_best = best_fitness;
+                from_chromosome_to_edges(inst, best_individual); //Update best solution
+                if (inst->params.verbose >= 3 && shared->num_islands > 1) {LOG_I("Island %d updated the incumbent: %0.2f", island->id, best_fitness);}
+            }
+            pthread_mutex_unlock(&(shared->mutex));
             //plot_solution(inst);
             //if (inst->params.verbose >= 3) {LOG_I("UPDATED INCUMBENT: %0.2f", best_fitness);}
 
@@ -531,36 +965,103 @@ int HEU_Genetic(instance *inst) {
         //}
         
         if (inst->params.verbose >= 4) {
-            LOG_I("Generation %d -> Mean: %0.2f      Best: %0.0f     Incumbent: %0.0f", generation, mean_fitness, best_fitness, incumbent);
+            LOG_I("Island %d generation %d -> Mean: %0.2f      Best: %0.0f     Incumbent: %0.0f", island->id, generation, mean_fitness, best_fitness, incumbent);
+        }
+
+        //MIGRATION: the best individuals travel between the islands
+        if (shared->num_islands > 1 && generation % MIGRATION_INTERVAL == 0) {
+            emigrate(island, arena);
+            immigrate(island, arena);
         }
 
         //SELECTION: select individuals which can go to the next generation
-        select_parents(population, parents, parent_size, pop_size);
+        select_parents(arena, rng);
 
         //CROSSOVER: Generate new individuals by combining two parents
-        procreate(inst, population, parents, parent_size, offsprings);
+        procreate(inst, arena, rng);
 
         // Mutation phase
-        mutation(inst, offsprings, offspring_size);
+        mutation(inst, arena, rng);
+
+        // Memetic phase
+        improve_offsprings(arena, rng);
         
         //Replace the individuals of the current populations with the children that has better fitness
-        choose_survivors(inst, population, pop_size, offsprings, offspring_size);
+        choose_survivors(arena, rng);
 
         generation++;
     }
-    
+    island->generations = generation;
 
 
     // Free allocations
-    for (int i = 0; i < pop_size; i++) {
-        FREE(population[i].chromosome);
+    arena_free(arena);
+
+    return NULL;
+}
+
+int HEU_Genetic(instance *inst) {
+    ga_shared shared;
+    shared.inst = inst;
+    gettimeofday(&(shared.start), 0); //Start counting time from now
+
+    //Set time limit
+    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {
+        LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);
+    }
+    shared.time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+
+    // The candidate lists are shared by the islands, so they are built before starting the threads
+    if (CROSSOVER_METHOD == CROSSOVER_EAX || MEMETIC_RATE > 0 || TWO_OPT_MUTATION_PROB > 0 || INIT_LOCAL_SEARCH) { get_candidate_lists(inst); }
+
+    // The population is split among the islands. Each island runs on its own thread
+    int num_islands = get_num_threads(inst);
+    if (num_islands > POPULATION_SIZE / MIN_ISLAND_SIZE) { num_islands = POPULATION_SIZE / MIN_ISLAND_SIZE; }
+    if (num_islands < 1) { num_islands = 1; }
+    shared.num_islands = num_islands;
+    int island_size = POPULATION_SIZE / num_islands;
+    if (inst->params.verbose >= 3) {LOG_I("Genetic algorithm with %d islands of %d individuals", num_islands, island_size);}
+
+    pthread_mutex_init(&(shared.mutex), NULL);
+    shared.migrant_genes = MALLOC((long) num_islands * NUM_MIGRANTS * inst->num_nodes, int);
+    shared.migrant_fitness = MALLOC(num_islands * NUM_MIGRANTS, double);
+    shared.num_migrants = CALLOC(num_islands, int);
+    shared.incumbent = DBL_MAX;
+    // The islands write the solution of the instance, so the copy used by their initialization is taken now
+    shared.scratch = *inst;
+    shared.scratch.solution.edges = NULL;
+    shared.scratch.solution.xbest = NULL;
+
+    ga_island *islands = CALLOC(num_islands, ga_island);
+    pthread_t *threads = MALLOC(num_islands, pthread_t);
+    for (int i = 0; i < num_islands; i++) {
+        islands[i].shared = &shared;
+        islands[i].id = i;
+        islands[i].pop_size = island_size;
+        rng_seed(&(islands[i].rng), inst->params.seed, i + 1); // Stream 0 is used by the main thread
     }
-    FREE(population);
-    FREE(parents);
-    for (int i = 0; i < offspring_size; i++) {
-        FREE(offsprings[i].chromosome);
+    for (int i = 1; i < num_islands; i++) {
+        pthread_create(&(threads[i]), NULL, evolve_island, &(islands[i]));
     }
-    FREE(offsprings);
+    evolve_island(&(islands[0])); // The main thread evolves the first island
+    for (int i = 1; i < num_islands; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (inst->params.verbose >= 3) {
+        unsigned int generations = 0;
+        for (int i = 0; i < num_islands; i++) { generations += islands[i].generations; }
+        LOG_I("Total generations of all the islands: %u", generations);
+    }
+    int status = islands[0].status;
+
+    // Free allocations
+    pthread_mutex_destroy(&(shared.mutex));
+    FREE(shared.migrant_genes);
+    FREE(shared.migrant_fitness);
+    FREE(shared.num_migrants);
+    FREE(islands);
+    FREE(threads);
 
     return status; 
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "gls.h"
+
+#include "heuristics.h"
+#include "distutil.h"
+#include "localsearch.h"
+#include "edgemap.h"
+
+////////////////////////////////////////////////////////
+///////////////// HYPERPARAMETERS //////////////////////
+////////////////////////////////////////////////////////
+#define PENALTY_FACTOR 0.3 // The cost of a penalty is this factor times the average edge cost of the first local optimum
+
+// The data of the augmented cost function
+typedef struct {
+    instance *inst;
+    edge_map *penalties; // The penalties of the edges. It contains only the penalized edges
+    int *penalized;     // The number of penalized edges of each node. The table is searched only when both endpoints have some
+    double lambda;      // The cost of a penalty
+} gls_state;
+
+/**
+ * Gives the penalty of the edge (i, j)
+ */
+static int penalty_get(const edge_map *penalties, int i, int j) {
+    int penalty;
+    return edge_map_get(penalties, i, j, &penalty) ? penalty : 0;
+}
+
+/**
+ * The augmented cost of an edge: its cost plus lambda times its penalty
+ */
+static double augmented_cost(int i, int j, void *data) {
+    gls_state *gs = (gls_state*) data;
+    double cost = calc_dist(i, j, gs->inst);
+    if (gs->penalized[i] == 0 || gs->penalized[j] == 0) return cost;
+    return cost + gs->lambda * penalty_get(gs->penalties, i, j);
+}
+
+int HEU_GLS(instance *inst) {
+    int n = inst->num_nodes;
+
+    //Set time limit
+    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);}
+    double time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+
+    //Start counting time from now
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+
+    //Compute initial solution: nearest neighbour (or warm start) improved with the local search
+    int status = HEU_initial_tour(inst);
+    if (status) {LOG_E("An error occurred in HEU_initial_tour");}
+    local_search *ls = ls_create(inst);
+    if (ls_load_edges(ls, inst->solution.edges)) {LOG_E("The initial solution is not a tour");}
+    ls_queue_all(ls);
+    ls_optimize(ls);
+    double best_obj = ls_tour_cost(ls);
+    int *best_tour = MALLOC(n, int);
+    ls_store(ls, best_tour);
+    if (inst->params.verbose >= 3) {LOG_I("Initial solution: %0.0f", best_obj);}
+
+    gls_state gs;
+    gs.inst = inst;
+    gs.penalties = edge_map_create(n, 1024);
+    gs.penalized = CALLOC(n, int);
+    gs.lambda = PENALTY_FACTOR * best_obj / n;
+    ls_set_cost(ls, augmented_cost, &gs);
+
+    int iterations = 0;
+    while (n >= 5) {
+        //Check elapsed time
+        gettimeofday(&end, 0);
+        if (get_elapsed_time(start, end) > time_limit) {
+            status = TIME_LIMIT_EXCEEDED;
+            break;
+        }
+        iterations++;
+
+        //Local optimum of the augmented costs. Only the nodes of the last penalized edges are in the queue
+        ls_optimize(ls);
+
+        //Compute the real cost of the tour and the highest utility of its edges
+        double cost = 0;
+        double max_utility = -1;
+        for (int pos = 0; pos < n; pos++) {
+            int i = ls->tour[pos];
+            int j = ls->tour[pos + 1 < n ? pos + 1 : 0];
+            double dist = calc_dist(i, j, inst);
+            cost += dist;
+            int penalty = gs.penalized[i] > 0 && gs.penalized[j] > 0 ? penalty_get(gs.penalties, i, j) : 0;
+            double utility = dist / (1 + penalty);
+            if (utility > max_utility) { max_utility = utility; }
+        }
+        if (cost < best_obj - EPS) {
+            best_obj = cost;
+            ls_store(ls, best_tour);
+            if (inst->params.verbose >= 3) {LOG_I("Iteration %d. Updated incumbent: %0.0f", iterations, best_obj);}
+        }
+
+        //Penalize the edges with the highest utility and search again from their endpoints
+        for (int pos = 0; pos < n; pos++) {
+            int i = ls->tour[pos];
+            int j = ls->tour[pos + 1 < n ? pos + 1 : 0];
+            double dist = calc_dist(i, j, inst);
+            if (dist < max_utility - EPS) continue; // The utility is at most the cost
+            int penalty = gs.penalized[i] > 0 && gs.penalized[j] > 0 ? penalty_get(gs.penalties, i, j) : 0;
+            if (dist / (1 + penalty) < max_utility - EPS) continue;
+            if (edge_map_put(gs.penalties, i, j, penalty + 1)) {
+                gs.penalized[i]++;
+                gs.penalized[j]++;
+            }
+            ls_queue_node(ls, i);
+            ls_queue_node(ls, j);
+        }
+        if (inst->params.verbose >= 4) {LOG_I("Iteration %d: current %0.0f, best %0.0f", iterations, cost, best_obj);}
+    }
+
+    if (inst->params.verbose >= 3) {
+        LOG_I("Guided local search: %d iterations, %ld penalized edges", iterations, gs.penalties->count);
+    }
+
+    //Polish the best tour with the real costs
+    ls_set_cost(ls, NULL, NULL);
+    ls_load(ls, best_tour);
+    ls_queue_all(ls);
+    ls_optimize(ls);
+    ls_store_edges(ls, inst->solution.edges);
+    inst->solution.obj_best = ls_tour_cost(ls);
+
+    // Free allocations
+    edge_map_free(gs.penalties);
+    FREE(gs.penalized);
+    FREE(best_tour);
+    ls_free(ls);
+    return status;
+}
@@ -46,7 +46,7 @@ void set_default_bounds(CPXENVptr env, CPXLPptr lp, int ncols, int *indexes, cha
 }
 
 //Function that fix the edges randomly
-void random_fix2(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *indexes, double *xh){
+void random_fix2(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *indexes, double *xh, rng_state *rng){
     double rand_num;
 	double one = 1.0;
 	char lb = 'L'; // Lower Bound
@@ -55,7 +55,7 @@ void random_fix2(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *index
     int num_cols = CPXgetnumcols(env, lp);
 
     for(int i = 0; i < num_cols; i++){
-		rand_num = (double) rand() / RAND_MAX;
+		rand_num = URAND(rng);
 		
 		if(xh[i] > 0.5 && rand_num < prob) {
 			CPXchgbds(env, lp, 1, &i, &lb, &one);
@@ -64,13 +64,13 @@ void random_fix2(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *index
     }
 }
 
-void random_fix(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *indexes, double *xh){
+void random_fix(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *indexes, double *xh, rng_state *rng){
     double rand_num;
     *ncols = 0;
     if(prob < 0 || prob > 1) { LOG_E("probability must be in [0,1]"); }
     int num_cols = CPXgetnumcols(env, lp);
     for(int i = 0; i < num_cols; i++) {
-		rand_num = (double) rand() / RAND_MAX;
+		rand_num = URAND(rng);
 		if(xh[i] > 0.5 && rand_num < prob) {
             indexes[(*ncols)++] = i;
 		}
@@ -86,7 +86,7 @@ void random_fix(CPXENVptr env, CPXLPptr lp, double prob, int *ncols, int *indexe
 }
 
 // Function that fix some edges
-void advanced_fix(CPXENVptr env, CPXLPptr lp, instance *inst, double prob, int *ncols, int *indexes, char *bounds, double *xh, edge *close_cycle_edges) {
+void advanced_fix(CPXENVptr env, CPXLPptr lp, instance *inst, double prob, int *ncols, int *indexes, char *bounds, double *xh, edge *close_cycle_edges, rng_state *rng) {
     double rand_num;
 	double one = 1.0;
 	char lb = 'L'; // Lower Bound
@@ -97,7 +97,7 @@ void advanced_fix(CPXENVptr env, CPXLPptr lp, instance *inst, double prob, int *
 
     double *xfake = CALLOC(num_cols, double); // We create a fake solution where the the nodes selected have the value of 1. This is threated such as a solution with subtours.
     for(int i = 0; i < num_cols; i++){
-		rand_num = URAND();
+		rand_num = URAND(rng);
 		
 		if(xh[i] > 0.5 && rand_num < prob) {
 			CPXchgbds(env, lp, 1, &i, &lb, &one);
@@ -198,8 +198,8 @@ int hard_fixing_solver(instance *inst, CPXENVptr env, CPXLPptr lp) {
         if (inst->params.verbose >= 5) {LOG_I("Time remaining: %0.1f seconds",time_remain);}
         
         // Fix some edges
-        //random_fix2(env, lp, prob, &ncols_fixed, indexes, xh);
-        advanced_fix(env, lp, inst, prob, &ncols_fixed, indexes, bounds, xh, close_cycle_edges);
+        //random_fix2(env, lp, prob, &ncols_fixed, indexes, xh, &(inst->rng));
+        advanced_fix(env, lp, inst, prob, &ncols_fixed, indexes, bounds, xh, close_cycle_edges, &(inst->rng));
 
         // Solve the model
         status = CPXmipopt(env, lp);
@@ -316,8 +316,8 @@ int hard_fixing_solver2(instance *inst, CPXENVptr env, CPXLPptr lp) {
         }
         
         //FIX some edges
-        //random_fix2(env, lp, prob, &ncols_fixed, indexes, xh);
-        advanced_fix(env, lp, inst, prob[prob_index], &ncols_fixed, indexes, bounds, xh, close_cycle_edges);
+        //random_fix2(env, lp, prob, &ncols_fixed, indexes, xh, &(inst->rng));
+        advanced_fix(env, lp, inst, prob[prob_index], &ncols_fixed, indexes, bounds, xh, close_cycle_edges, &(inst->rng));
 
         // Solve the model
         status = CPXmipopt(env, lp);
@@ -0,0 +1,116 @@
+#include "heap.h"
+
+static inline void swap_slots(heap *h, int a, int b) {
+    int item = h->items[a];
+    double key = h->keys[a];
+    h->items[a] = h->items[b];
+    h->keys[a] = h->keys[b];
+    h->items[b] = item;
+    h->keys[b] = key;
+    h->pos[h->items[a]] = a;
+    h->pos[h->items[b]] = b;
+}
+
+static void sift_up(heap *h, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (h->keys[parent] <= h->keys[i]) break;
+        swap_slots(h, i, parent);
+        i = parent;
+    }
+}
+
+static void sift_down(heap *h, int i) {
+    while (1) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int min = i;
+        if (left < h->size && h->keys[left] < h->keys[min]) min = left;
+        if (right < h->size && h->keys[right] < h->keys[min]) min = right;
+        if (min == i) break;
+        swap_slots(h, i, min);
+        i = min;
+    }
+}
+
+heap* heap_create(int max_items) {
+    heap *h = MALLOC(1, heap);
+    h->size = 0;
+    h->max_items = max_items;
+    h->items = MALLOC(max_items, int);
+    h->keys = MALLOC(max_items, double);
+    h->pos = MALLOC(max_items, int);
+    MEMSET(h->pos, -1, max_items, int);
+    return h;
+}
+
+void heap_free(heap *h) {
+    if (h == NULL) return;
+    FREE(h->items);
+    FREE(h->keys);
+    FREE(h->pos);
+    free(h);
+}
+
+void heap_clear(heap *h) {
+    for (int i = 0; i < h->size; i++) {
+        h->pos[h->items[i]] = -1;
+    }
+    h->size = 0;
+}
+
+void heap_push(heap *h, int item, double key) {
+    int i = h->pos[item];
+    if (i >= 0) {
+        double old = h->keys[i];
+        h->keys[i] = key;
+        if (key < old) { sift_up(h, i); } else { sift_down(h, i); }
+        return;
+    }
+    i = h->size++;
+    h->items[i] = item;
+    h->keys[i] = key;
+    h->pos[item] = i;
+    sift_up(h, i);
+}
+
+void heap_build(heap *h, const int *items, const double *keys, int num_items) {
+    for (int i = 0; i < num_items; i++) {
+        h->items[i] = items[i];
+        h->keys[i] = keys[i];
+        h->pos[items[i]] = i;
+    }
+    h->size = num_items;
+    for (int i = num_items / 2 - 1; i >= 0; i--) {
+        sift_down(h, i);
+    }
+}
+
+int heap_pop(heap *h, double *key) {
+    if (h->size == 0) return -1;
+    int item = h->items[0];
+    if (key) *key = h->keys[0];
+    h->size--;
+    if (h->size > 0) {
+        swap_slots(h, 0, h->size);
+        sift_down(h, 0);
+    }
+    h->pos[item] = -1;
+    return item;
+}
+
+void heap_remove(heap *h, int item) {
+    int i = h->pos[item];
+    if (i < 0) return;
+    h->size--;
+    if (i != h->size) {
+        swap_slots(h, i, h->size);
+        sift_down(h, i);
+        sift_up(h, i);
+    }
+    h->pos[item] = -1;
+}
+
+int heap_contains(const heap *h, int item) {
+    return h->pos[item] >= 0;
+}
@@ -2,14 +2,14 @@
 
 #include "distutil.h"
 #include "convexhull.h"
+#include "kdtree.h"
+#include "heap.h"
+#include "candidates.h"
 
 #include <float.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
-#define GRASP_RAND 0.9
-#define GRASP_ITER_TIME_LIM 120 // 2 minutes
-
 /////////////////////////////////////////////////////////////////////////
 ///////////////// CONSTRUCTIVE HEURISTICS ///////////////////////////////
 /////////////////////////////////////////////////////////////////////////
@@ -39,6 +39,17 @@ int greedy(instance *inst, int starting_node) {
         double elapsed = get_elapsed_time(start, end);
         if (inst->params.time_limit > 0 && elapsed > inst->params.time_limit) {
             status = TIME_LIMIT_EXCEEDED;
+            //Out of time: the not visited nodes are appended in index order, so the solution is still a tour
+            for (int i = 0; i < inst->num_nodes; i++) {
+                if (visited[i]) { continue; }
+                inst->solution.edges[curr].i = curr;
+                inst->solution.edges[curr].j = i;
+                obj += calc_dist(curr, i, inst);
+                visited[i] = 1;
+                curr = i;
+            }
+            inst->solution.edges[curr].i = curr;
+            inst->solution.edges[curr].j = starting_node;
             break;
         }
 
@@ -78,8 +89,9 @@ int greedy(instance *inst, int starting_node) {
 }
 
 
-//Nearest Neighboor algorithm O(n^2) in which we choose whith some probability between the nearest and the 2° nearest node
-int grasp(instance *inst, int starting_node) {
+//Nearest Neighboor algorithm in which we choose randomly from a restricted candidate list (RCL) of the k nearest not visited nodes.
+//The RCL is served by the spatial index so each step costs O(log n + k) instead of O(n)
+int grasp(instance *inst, int starting_node, kdtree *tree, rng_state *rng) {
     //Check if the starting node is valid
     if (starting_node >= inst->num_nodes) {return WRONG_STARTING_NODE;}
 
@@ -87,13 +99,22 @@ int grasp(instance *inst, int starting_node) {
     struct timeval start, end;
     gettimeofday(&start, 0);
 
-    //Initialize array of visited nodes to 0
-    int *visited = CALLOC(inst->num_nodes, int);
+    //The spatial index keeps only the not visited nodes
+    int own_tree = tree == NULL;
+    if (own_tree) {
+        tree = kdtree_build(inst);
+    } else {
+        kdtree_reset(tree);
+    }
+    int rcl_size = inst->params.grasp_rcl > 0 ? inst->params.grasp_rcl : 1;
+    double alpha = inst->params.grasp_alpha;
+    int *rcl = MALLOC(rcl_size, int);
+    double *rcl_dist = MALLOC(rcl_size, double); // Work memory of the spatial index queries
     double obj = 0;
 
     //Mark starting node as visited
     int curr = starting_node;
-    visited[starting_node] = 1;
+    kdtree_remove(tree, starting_node);
     int status = 0;
 
     //While there is some node to visit and we are within the time limit
@@ -106,52 +127,46 @@ int grasp(instance *inst, int starting_node) {
             break;
         }
 
-        //For each non visited node: pick the one that is the nearest, rembering also the second nearest
-        int first_minidx = -1; // The index of the nearest node 
-        double first_mindist = DBL_MAX; 
-        int second_minidx = first_minidx; // The index of the 2nd nearest node
-        double second_mindist = first_mindist;
-        for (int i = 0; i < inst->num_nodes; i++) {
-            if (curr == i || visited[i]) { continue; }
-            double currdist = calc_dist(curr, i, inst);
-            if (currdist < first_mindist) {       // update nearest and 2° nearest nodes
-                second_mindist = first_mindist;
-                second_minidx = first_minidx;
-                first_mindist = currdist;
-                first_minidx = i;
-            }
-        }
-        
-        //Now we have the 2 nearest nodes to the current one
-        //We select with probability GRASP_RAND the nearest node
-        double rand_num = URAND();
-        int idxsel = rand_num < GRASP_RAND || first_minidx == -1 || second_minidx == -1 ? first_minidx : second_minidx;
+        //The RCL is composed by the k nearest not visited nodes sorted by distance
+        int found = kdtree_knn(tree, curr, rcl_size, rcl, rcl_dist);
 
-        // No new nearest node is found so the algorithm shuts down and closes the hamiltonian cycle
-        if (idxsel == -1) { 
-            // Closing the tsp cycle 
-            inst->solution.edges[curr].i = curr;
-            inst->solution.edges[curr].j = starting_node;
-            obj += calc_dist(curr, starting_node, inst); // Calculates the distance of the closing edge
+        // No new node is found so the algorithm shuts down and closes the hamiltonian cycle
+        if (found == 0) { 
             break;
         }
 
-        // The distance of the selected node. If the nearest node was selected, the nearest distance is returned and viceversa
-        //double distsel = random < GRASP_RAND ? first_mindist : second_mindist;    //This LINE causes infinite cost
-        double distsel = idxsel==first_minidx ? first_mindist : second_mindist;
+        int sel = 0; // The position of the selected node in the RCL
+        if (alpha >= 0) {
+            //Alpha mode: we select uniformly among the candidates whose cost is within d_min + alpha * (d_max - d_min)
+            double dmin = calc_dist(curr, rcl[0], inst);
+            double dmax = calc_dist(curr, rcl[found - 1], inst);
+            double threshold = dmin + alpha * (dmax - dmin);
+            int num_candidates = 1;
+            while (num_candidates < found && calc_dist(curr, rcl[num_candidates], inst) <= threshold) { num_candidates++; }
+            sel = rand_choice(0, num_candidates, rng);
+        } else if (found > 1 && URAND(rng) >= inst->params.grasp_rand) {
+            //We select with probability grasp_rand the nearest node, otherwise one of the others in the RCL
+            sel = rand_choice(1, found, rng);
+        }
+        int idxsel = rcl[sel];
 
         //Set the edge between the 2 nodes
         inst->solution.edges[curr].i = curr;
         inst->solution.edges[curr].j = idxsel;
 
-        visited[idxsel] = 1;        //mark the selected node as visited
-        obj += distsel;             //update tour cost
-        curr = idxsel;              //new current node is the selected one
+        kdtree_remove(tree, idxsel);                //mark the selected node as visited
+        obj += calc_dist(curr, idxsel, inst);       //update tour cost
+        curr = idxsel;                              //new current node is the selected one
     }
     
+    // Closing the tsp cycle 
+    inst->solution.edges[curr].i = curr;
+    inst->solution.edges[curr].j = starting_node;
     obj += calc_dist(curr, starting_node, inst);
     inst->solution.obj_best = obj;  //save tour cost
-    FREE(visited);
+    FREE(rcl);
+    FREE(rcl_dist);
+    if (own_tree) { kdtree_free(tree); }
     return status;
 }
 
@@ -163,6 +178,41 @@ int HEU_greedy(instance *inst) {
     return status;
 }
 
+//Starts from the warm start tour when given, otherwise from the nearest neighbour tour from node 0.
+//The nearest neighbour is served by the spatial index in O(n log n) and it is not cut by the time limit,
+//so the tour is always complete
+int HEU_initial_tour(instance *inst) {
+    int n = inst->num_nodes;
+    double obj = 0;
+    if (inst->warm_start == NULL) {
+        kdtree *tree = kdtree_build(inst);
+        int curr = 0;
+        kdtree_remove(tree, curr);
+        for (int step = 1; step < n; step++) {
+            int next = kdtree_nearest(tree, curr);
+            kdtree_remove(tree, next);
+            inst->solution.edges[curr].i = curr;
+            inst->solution.edges[curr].j = next;
+            obj += calc_dist(curr, next, inst);
+            curr = next;
+        }
+        inst->solution.edges[curr].i = curr;
+        inst->solution.edges[curr].j = 0;
+        inst->solution.obj_best = obj + calc_dist(curr, 0, inst);
+        kdtree_free(tree);
+        return 0;
+    }
+    for (int pos = 0; pos < n; pos++) {
+        int i = inst->warm_start[pos];
+        int j = inst->warm_start[pos + 1 < n ? pos + 1 : 0];
+        inst->solution.edges[i].i = i;
+        inst->solution.edges[i].j = j;
+        obj += calc_dist(i, j, inst);
+    }
+    inst->solution.obj_best = obj;
+    return 0;
+}
+
 
 //Multistart algorithm: start a nearest neighboor for each node O(n^3)
 int HEU_Greedy_iter(instance *inst) {
@@ -204,6 +254,10 @@ int HEU_Greedy_iter(instance *inst) {
     return status;
 }
 
+double extra_mileage(int a, int b, int c, instance *inst) {
+    return calc_dist(a, c, inst) + calc_dist(c, b, inst) - calc_dist(a, b, inst);   //Delta (a,b,c)= C_ac + C_cb - C_ab
+}
+
 //Extramileage algorithm 
 int HEU_extramileage(instance *inst) {
     int *nodes_visited = CALLOC(inst->num_nodes, int); // Stores nodes visited in tour
@@ -269,10 +323,7 @@ int HEU_extramileage(instance *inst) {
                 int a = e.i;
                 int b = e.j;
                 int c = i;
-                double cost1 = calc_dist(a, c, inst);
-                double cost2 = calc_dist(c, b, inst);
-                double cost3 = calc_dist(a, b, inst);
-                double deltacost = cost1 + cost2 - cost3;   //Delta (a,b,c)= C_ac + C_cb - C_ab
+                double deltacost = extra_mileage(a, b, c, inst);
                 if (deltacost < min_mileage) {
                     min_mileage = deltacost;
                     best_edge = e;
@@ -383,10 +434,7 @@ int HEU_extramileage2(instance *inst) {
                 int a = e.i;
                 int b = e.j;
                 int c = i;
-                double cost1 = calc_dist(a, c, inst);
-                double cost2 = calc_dist(c, b, inst);
-                double cost3 = calc_dist(a, b, inst);
-                double deltacost = cost1 + cost2 - cost3;   //Delta (a,b,c)= C_ac + C_cb - C_ab
+                double deltacost = extra_mileage(a, b, c, inst);
                 if (deltacost < min_mileage) {
                     min_mileage = deltacost;
                     best_edge = e;
@@ -430,6 +478,403 @@ int HEU_extramileage2(instance *inst) {
 }
 
 
+/**
+ * Links two nodes in the adjacency lists used by savings and by the constructive heuristics that build
+ * the tour as a set of paths
+ */
+static inline void link_nodes(int *adj, int *deg, int a, int b) {
+    adj[2 * a + deg[a]++] = b;
+    adj[2 * b + deg[b]++] = a;
+}
+
+/**
+ * Stores in the solution the tour described by the adjacency lists (each node has exactly 2 neighbours)
+ * 
+ * @returns The cost of the tour
+ */
+static double adjacency_to_solution(instance *inst, const int *adj, int start) {
+    double obj = 0;
+    int prev = adj[2 * start + 1];
+    int curr = start;
+    for (int k = 0; k < inst->num_nodes; k++) {
+        int next = adj[2 * curr] != prev ? adj[2 * curr] : adj[2 * curr + 1];
+        inst->solution.edges[curr].i = curr;
+        inst->solution.edges[curr].j = next;
+        obj += calc_dist(curr, next, inst);
+        prev = curr;
+        curr = next;
+    }
+    return obj;
+}
+
+//Clarke-Wright savings algorithm restricted to the candidate pairs O(n*k*log(n*k))
+int savings(instance *inst, int hub) {
+    if (hub < 0 || hub >= inst->num_nodes) {return WRONG_STARTING_NODE;}
+    int n = inst->num_nodes;
+    if (n < 3) {return greedy(inst, hub);}
+    candidate_list *cand = get_candidate_lists(inst);
+    int k = cand->k;
+
+    int *adj = MALLOC(2 * n, int);       // The two neighbours of each node in the paths
+    int *deg = CALLOC(n, int);           // The number of neighbours of each node
+    int *other_end = MALLOC(n, int);     // For a path's endpoint, the opposite endpoint of its path
+    for (int i = 0; i < n; i++) {
+        other_end[i] = i;   // Initially each node is a path of a single node: hub - i - hub
+    }
+
+    // The saving of joining i and j is s(i,j) = d(hub,i) + d(hub,j) - d(i,j). The heap is a min-heap so the keys are -s(i,j).
+    // The pair (i, c-th candidate of i) is the item i * k + c. Each pair is considered once.
+    int *items = MALLOC((long) n * k, int);
+    double *keys = MALLOC((long) n * k, double);
+    int num_items = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == hub) continue;
+        for (int c = 0; c < k; c++) {
+            int j = cand->neighbours[(long) i * k + c];
+            if (j == hub) continue;
+            if (j < i && is_candidate(cand, j, i)) continue; // Pair already inserted from j's list
+            items[num_items] = i * k + c;
+            keys[num_items] = calc_dist(i, j, inst) - calc_dist(hub, i, inst) - calc_dist(hub, j, inst);
+            num_items++;
+        }
+    }
+    heap *h = heap_create(n * k);
+    heap_build(h, items, keys, num_items);
+    FREE(items);
+    FREE(keys);
+
+    // Merging the paths in decreasing order of savings. Two paths can be merged only through their endpoints
+    int num_paths = n - 1;
+    while (num_paths > 1) {
+        int item = heap_pop(h, NULL);
+        if (item < 0) break;
+        int i = item / k;
+        int j = cand->neighbours[item];
+        if (deg[i] >= 2 || deg[j] >= 2) continue; // Not endpoints anymore
+        if (other_end[i] == j) continue; // Same path: the merge would close a cycle
+        int a = other_end[i];
+        int b = other_end[j];
+        link_nodes(adj, deg, i, j);
+        other_end[a] = b;
+        other_end[b] = a;
+        num_paths--;
+    }
+    heap_free(h);
+
+    // The candidate pairs may not be enough to obtain a single path. The remaining paths are joined in a nearest
+    // neighbour fashion: from the end of the current path we move to the nearest endpoint of another path
+    if (num_paths > 1) {
+        kdtree *tree = kdtree_build(inst);
+        for (int i = 0; i < n; i++) {
+            if (i == hub || deg[i] >= 2) { kdtree_remove(tree, i); }
+        }
+        int first = -1;
+        for (int i = 0; i < n && first < 0; i++) {
+            if (i != hub && deg[i] < 2) { first = i; }
+        }
+        int end = other_end[first];
+        kdtree_remove(tree, first);
+        kdtree_remove(tree, end);
+        while (num_paths > 1) {
+            int next = kdtree_nearest(tree, end);
+            int next_end = other_end[next];
+            kdtree_remove(tree, next);
+            kdtree_remove(tree, next_end);
+            link_nodes(adj, deg, end, next);
+            other_end[first] = next_end;
+            other_end[next_end] = first;
+            end = next_end;
+            num_paths--;
+        }
+        kdtree_free(tree);
+    }
+
+    // Closing the tour through the hub
+    int first = -1;
+    for (int i = 0; i < n && first < 0; i++) {
+        if (i != hub && deg[i] < 2) { first = i; }
+    }
+    link_nodes(adj, deg, hub, first);
+    link_nodes(adj, deg, hub, other_end[first]);
+
+    inst->solution.obj_best = adjacency_to_solution(inst, adj, hub);
+    FREE(adj);
+    FREE(deg);
+    FREE(other_end);
+    return 0;
+}
+
+//Wrapper function that calls the savings algorithm using as hub the node nearest to the center of the instance
+int HEU_Savings(instance *inst) {
+    point center = {0, 0};
+    for (int i = 0; i < inst->num_nodes; i++) {
+        center.x += inst->nodes[i].x / inst->num_nodes;
+        center.y += inst->nodes[i].y / inst->num_nodes;
+    }
+    int hub = 0;
+    double min_dist = DBL_MAX;
+    for (int i = 0; i < inst->num_nodes; i++) {
+        double dx = inst->nodes[i].x - center.x;
+        double dy = inst->nodes[i].y - center.y;
+        if (dx * dx + dy * dy < min_dist) {
+            min_dist = dx * dx + dy * dy;
+            hub = i;
+        }
+    }
+    if (inst->params.verbose >= 4) {LOG_I("SAVINGS hub node: %d", hub);}
+    return savings(inst, hub);
+}
+
+
+//Prim's algorithm on the symmetric candidate graph O(n*k*log n). The components of the candidate graph are joined lazily through the spatial index
+double prim_mst(instance *inst, int *parent) {
+    int n = inst->num_nodes;
+    candidate_list *cand = get_candidate_lists(inst);
+    int k = cand->k;
+
+    // Symmetric candidate graph in compressed form: the neighbours of node i are adj[beg[i]] ... adj[beg[i + 1] - 1]
+    int *beg = CALLOC(n + 1, int);
+    for (int i = 0; i < n; i++) {
+        for (int c = 0; c < k; c++) {
+            beg[i + 1]++;
+            beg[cand->neighbours[(long) i * k + c] + 1]++;
+        }
+    }
+    for (int i = 0; i < n; i++) { beg[i + 1] += beg[i]; }
+    int *fill = MALLOC(n, int);
+    memcpy(fill, beg, n * sizeof(int));
+    int *adj = MALLOC(beg[n], int);
+    for (int i = 0; i < n; i++) {
+        for (int c = 0; c < k; c++) {
+            int j = cand->neighbours[(long) i * k + c];
+            adj[fill[i]++] = j;
+            adj[fill[j]++] = i;
+        }
+    }
+    FREE(fill);
+
+    char *in_tree = CALLOC(n, char);
+    double *key = MALLOC(n, double);
+    MEMSET(key, DBL_MAX, n, double);
+    MEMSET(parent, -1, n, int);
+    heap *h = heap_create(n);
+    // When the candidate graph is not connected, each node of the tree keeps in a second heap its nearest node
+    // outside of the tree, found through the spatial index. An entry becomes stale when that node enters the tree,
+    // and it is computed again only when it reaches the top of the heap
+    kdtree *outside = kdtree_build(inst); // The nodes not yet in the tree
+    heap *bridges = heap_create(n);
+    int *nearest_out = MALLOC(n, int);
+    int bridging = 0; // 1 once the candidate graph is found not connected
+
+    double weight = 0;
+    int num_in_tree = 0;
+    key[0] = 0;
+    heap_push(h, 0, 0);
+    while (num_in_tree < n) {
+        int u = heap_pop(h, NULL);
+        if (u < 0) {
+            // The candidate graph is not connected. The tree is connected to the nearest node outside of it
+            if (!bridging) {
+                for (int i = 0; i < n; i++) {
+                    if (!in_tree[i]) continue;
+                    nearest_out[i] = kdtree_nearest(outside, i);
+                    heap_push(bridges, i, calc_dist(i, nearest_out[i], inst));
+                }
+                bridging = 1;
+            }
+            // The stale keys are not greater than the real ones, so the first valid entry is the shortest edge
+            while (1) {
+                double dist;
+                int i = heap_pop(bridges, &dist);
+                if (!in_tree[nearest_out[i]]) {
+                    u = nearest_out[i];
+                    parent[u] = i;
+                    key[u] = dist;
+                    heap_push(bridges, i, dist); // It becomes stale and it is computed again when needed
+                    break;
+                }
+                nearest_out[i] = kdtree_nearest(outside, i);
+                heap_push(bridges, i, calc_dist(i, nearest_out[i], inst));
+            }
+        }
+        in_tree[u] = 1;
+        num_in_tree++;
+        kdtree_remove(outside, u);
+        if (parent[u] >= 0) { weight += key[u]; }
+        if (bridging && num_in_tree < n) {
+            nearest_out[u] = kdtree_nearest(outside, u);
+            heap_push(bridges, u, calc_dist(u, nearest_out[u], inst));
+        }
+
+        for (int e = beg[u]; e < beg[u + 1]; e++) {
+            int v = adj[e];
+            if (in_tree[v]) continue;
+            double dist = calc_dist(u, v, inst);
+            if (dist < key[v]) {
+                key[v] = dist;
+                parent[v] = u;
+                heap_push(h, v, dist);
+            }
+        }
+    }
+
+    heap_free(h);
+    heap_free(bridges);
+    kdtree_free(outside);
+    FREE(nearest_out);
+    FREE(in_tree);
+    FREE(key);
+    FREE(beg);
+    FREE(adj);
+    return weight;
+}
+
+//Christofides-like algorithm: MST + greedy matching of the odd degree nodes + Euler tour + shortcutting
+int christofides(instance *inst) {
+    int n = inst->num_nodes;
+    if (n < 3) {return greedy(inst, 0);}
+    candidate_list *cand = get_candidate_lists(inst);
+    int k = cand->k;
+
+    int *parent = MALLOC(n, int);
+    double mst_weight = prim_mst(inst, parent);
+    if (inst->params.verbose >= 3) {LOG_I("Spanning tree weight (estimate of the MST weight): %0.2f", mst_weight);}
+
+    // The multigraph has the n - 1 tree edges and at most n / 2 matching edges
+    int max_edges = n - 1 + n / 2;
+    edge *multigraph = MALLOC(max_edges, edge);
+    int num_edges = 0;
+    int *deg = CALLOC(n, int);
+    for (int i = 0; i < n; i++) {
+        if (parent[i] < 0) continue;
+        edge e = {i, parent[i]};
+        multigraph[num_edges++] = e;
+        deg[i]++;
+        deg[parent[i]]++;
+    }
+
+    // Greedy matching of the odd degree nodes. First the pairs of odd nodes which are near each other
+    // are matched in increasing order of distance, then the remaining odd nodes are matched with the nearest unmatched one
+    kdtree *odd = kdtree_build(inst);
+    for (int i = 0; i < n; i++) {
+        if (deg[i] % 2 == 0) { kdtree_remove(odd, i); }
+    }
+    int *items = MALLOC((long) n * k, int);
+    double *keys = MALLOC((long) n * k, double);
+    int *odd_neighbours = MALLOC((long) n * k, int); // The k nearest odd nodes of each odd node
+    double *odd_dist = MALLOC(k, double);
+    int num_items = 0;
+    for (int i = 0; i < n; i++) {
+        if (deg[i] % 2 == 0) continue;
+        int found = kdtree_knn(odd, i, k, &(odd_neighbours[(long) i * k]), odd_dist);
+        for (int c = 0; c < found; c++) {
+            // The pair (i, c-th nearest odd node) is the item i * k + c
+            items[num_items] = i * k + c;
+            keys[num_items] = calc_dist(i, odd_neighbours[(long) i * k + c], inst);
+            num_items++;
+        }
+    }
+    heap *h = heap_create(n * k);
+    heap_build(h, items, keys, num_items);
+    char *matched = CALLOC(n, char);
+    while (1) {
+        int item = heap_pop(h, NULL);
+        if (item < 0) break;
+        int i = item / k;
+        int j = odd_neighbours[item];
+        if (matched[i] || matched[j]) continue;
+        matched[i] = matched[j] = 1;
+        kdtree_remove(odd, i);
+        kdtree_remove(odd, j);
+        edge e = {i, j};
+        multigraph[num_edges++] = e;
+    }
+    for (int i = 0; i < n; i++) {
+        if (deg[i] % 2 == 0 || matched[i]) continue;
+        kdtree_remove(odd, i);
+        int j = kdtree_nearest(odd, i);
+        kdtree_remove(odd, j);
+        matched[i] = matched[j] = 1;
+        edge e = {i, j};
+        multigraph[num_edges++] = e;
+    }
+    heap_free(h);
+    kdtree_free(odd);
+    FREE(items);
+    FREE(keys);
+    FREE(odd_neighbours);
+    FREE(odd_dist);
+    FREE(matched);
+
+    // Adjacency lists of the multigraph in compressed form. Each entry stores the edge index
+    int *beg = CALLOC(n + 1, int);
+    for (int e = 0; e < num_edges; e++) {
+        beg[multigraph[e].i + 1]++;
+        beg[multigraph[e].j + 1]++;
+    }
+    for (int i = 0; i < n; i++) { beg[i + 1] += beg[i]; }
+    int *next_edge = MALLOC(n, int); // The next edge to scan of each node in the Euler tour
+    memcpy(next_edge, beg, n * sizeof(int));
+    int *incident = MALLOC(2 * num_edges, int);
+    for (int e = 0; e < num_edges; e++) {
+        incident[next_edge[multigraph[e].i]++] = e;
+        incident[next_edge[multigraph[e].j]++] = e;
+    }
+    memcpy(next_edge, beg, n * sizeof(int));
+
+    // Euler tour with Hierholzer's algorithm. The tour is shortcut on the fly skipping the visited nodes
+    char *used = CALLOC(num_edges, char);
+    char *visited = CALLOC(n, char);
+    int *stack = MALLOC((num_edges + 1), int);
+    int *tour = MALLOC(n, int);
+    int tour_size = 0;
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int u = stack[top - 1];
+        while (next_edge[u] < beg[u + 1] && used[incident[next_edge[u]]]) { next_edge[u]++; }
+        if (next_edge[u] == beg[u + 1]) {
+            top--;
+            if (!visited[u]) {
+                visited[u] = 1;
+                tour[tour_size++] = u;
+            }
+            continue;
+        }
+        int e = incident[next_edge[u]];
+        used[e] = 1;
+        stack[top++] = multigraph[e].i == u ? multigraph[e].j : multigraph[e].i;
+    }
+
+    double obj = 0;
+    for (int p = 0; p < n; p++) {
+        int a = tour[p];
+        int b = tour[(p + 1) % n];
+        inst->solution.edges[a].i = a;
+        inst->solution.edges[a].j = b;
+        obj += calc_dist(a, b, inst);
+    }
+    inst->solution.obj_best = obj;
+
+    FREE(parent);
+    FREE(multigraph);
+    FREE(deg);
+    FREE(beg);
+    FREE(next_edge);
+    FREE(incident);
+    FREE(used);
+    FREE(visited);
+    FREE(stack);
+    FREE(tour);
+    return 0;
+}
+
+//Wrapper function that calls the Christofides-like algorithm
+int HEU_Christofides(instance *inst) {
+    return christofides(inst);
+}
+
+
 /////////////////////////////////////////////////////////////////////////
 ///////////////// REFINEMENT HEURISTICS /////////////////////////////////
 /////////////////////////////////////////////////////////////////////////
@@ -503,7 +948,7 @@ int alg_2opt(instance *inst) {
 
 //Wrapper function that execute GRASP algorithm
 int HEU_Grasp(instance *inst) {
-    return grasp(inst, 0);  //Execute GRASP starting from node 0
+    return grasp(inst, 0, NULL, &(inst->rng));  //Execute GRASP starting from node 0
 }
 
 //MULTISTART algorithm for GRASP: start a GRASP for each node
@@ -512,11 +957,12 @@ int HEU_Grasp_iter(instance *inst, int time_lim) {
     double bestobj = DBL_MAX;
     edge *bestedges = CALLOC(inst->num_nodes, edge);
     struct timeval start, end;
-    int grasp_time_lim = time_lim > 0 ? time_lim : GRASP_ITER_TIME_LIM;
+    int grasp_time_lim = time_lim > 0 ? time_lim : inst->params.grasp_time_lim;
+    kdtree *tree = kdtree_build(inst); // The spatial index is built once and reused by every GRASP run
     gettimeofday(&start, 0);
     
     while (1) {
-        int node = URAND() * (inst->num_nodes - 1);
+        int node = rand_choice(0, inst->num_nodes, &(inst->rng));
         gettimeofday(&end, 0);
         double elapsed = get_elapsed_time(start, end);
         if (elapsed >= grasp_time_lim) {
@@ -526,7 +972,7 @@ int HEU_Grasp_iter(instance *inst, int time_lim) {
         if (inst->params.verbose >= 5) {
             LOG_I("GRASP starting node: %d", node);
         }
-        status = grasp(inst, node);
+        status = grasp(inst, node, tree, &(inst->rng));
         if (status) { break; }
         if (inst->solution.obj_best < bestobj) {
             if(inst->params.verbose >= 4) {
@@ -540,6 +986,7 @@ int HEU_Grasp_iter(instance *inst, int time_lim) {
     inst->solution.obj_best = bestobj;
     memcpy(inst->solution.edges, bestedges, inst->num_nodes * sizeof(edge));
     FREE(bestedges);
+    kdtree_free(tree);
     return status;
 }
 
@@ -604,3 +1051,26 @@ int HEU_2opt_extramileage(instance *inst) {
     return status;
 }
 
+//Savings initialization + 2opt refinement
+int HEU_2opt_savings(instance *inst) {
+    int status = HEU_Savings(inst);
+    if(inst->params.verbose >= 5) {
+        LOG_I("COMPLETED SAVINGS");
+        LOG_I("STARTED 2-OPT REFINEMENT");
+    }
+    plot_solution(inst);
+    status = alg_2opt(inst);
+    return status;
+}
+
+//Christofides initialization + 2opt refinement
+int HEU_2opt_christofides(instance *inst) {
+    int status = HEU_Christofides(inst);
+    if(inst->params.verbose >= 5) {
+        LOG_I("COMPLETED CHRISTOFIDES");
+        LOG_I("STARTED 2-OPT REFINEMENT");
+    }
+    plot_solution(inst);
+    status = alg_2opt(inst);
+    return status;
+}
\ No newline at end of file
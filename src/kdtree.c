@@ -0,0 +1,198 @@
+#include "kdtree.h"
+
+#include <float.h>
+
+// The context of a k nearest neighbours query
+typedef struct {
+    int query;          // The query node
+    point q;            // The coordinates of the query node
+    int k;              // The number of neighbours requested
+    int found;          // The number of neighbours found so far
+    int *neighbours;    // The neighbours found sorted by increasing distance
+    double *sqdist;     // The squared distances of the neighbours found
+} knn_query;
+
+static inline double coord(point p, int dim) {
+    return dim == 0 ? p.x : p.y;
+}
+
+static inline double sqdistance(point p1, point p2) {
+    double dx = p1.x - p2.x;
+    double dy = p1.y - p2.y;
+    return dx * dx + dy * dy;
+}
+
+/**
+ * Partially sorts the range [lo, hi) of perm such that the element in position kth is the one
+ * that would be in that position if the range was sorted by the coordinate dim (quickselect)
+ */
+static void select_kth(point *nodes, int *perm, int lo, int hi, int kth, int dim) {
+    hi--;
+    while (hi > lo) {
+        double pivot = coord(nodes[perm[(lo + hi) / 2]], dim);
+        int i = lo;
+        int j = hi;
+        while (i <= j) {
+            while (coord(nodes[perm[i]], dim) < pivot) i++;
+            while (coord(nodes[perm[j]], dim) > pivot) j--;
+            if (i <= j) {
+                int tmp = perm[i];
+                perm[i] = perm[j];
+                perm[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        if (kth <= j) {
+            hi = j;
+        } else if (kth >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+}
+
+static void build(kdtree *tree, int lo, int hi) {
+    if (lo >= hi) return;
+    int mid = (lo + hi) / 2;
+
+    // Splits on the dimension with the largest spread
+    double minx = DBL_MAX, maxx = -DBL_MAX, miny = DBL_MAX, maxy = -DBL_MAX;
+    for (int i = lo; i < hi; i++) {
+        point p = tree->nodes[tree->perm[i]];
+        if (p.x < minx) minx = p.x;
+        if (p.x > maxx) maxx = p.x;
+        if (p.y < miny) miny = p.y;
+        if (p.y > maxy) maxy = p.y;
+    }
+    int dim = (maxx - minx) >= (maxy - miny) ? 0 : 1;
+    select_kth(tree->nodes, tree->perm, lo, hi, mid, dim);
+    tree->dim[mid] = dim;
+    tree->count[mid] = hi - lo;
+    
+    build(tree, lo, mid);
+    build(tree, mid + 1, hi);
+}
+
+static void reset_counts(kdtree *tree, int lo, int hi) {
+    if (lo >= hi) return;
+    int mid = (lo + hi) / 2;
+    tree->count[mid] = hi - lo;
+    reset_counts(tree, lo, mid);
+    reset_counts(tree, mid + 1, hi);
+}
+
+kdtree* kdtree_build(instance *inst) {
+    int n = inst->num_nodes;
+    kdtree *tree = MALLOC(1, kdtree);
+    tree->num_nodes = n;
+    tree->nodes = inst->nodes;
+    tree->perm = MALLOC(n, int);
+    tree->pos = MALLOC(n, int);
+    tree->dim = MALLOC(n, char);
+    tree->count = MALLOC(n, int);
+    tree->active = MALLOC(n, char);
+    for (int i = 0; i < n; i++) {
+        tree->perm[i] = i;
+        tree->active[i] = 1;
+    }
+    build(tree, 0, n);
+    for (int i = 0; i < n; i++) {
+        tree->pos[tree->perm[i]] = i;
+    }
+    return tree;
+}
+
+void kdtree_free(kdtree *tree) {
+    if (tree == NULL) return;
+    FREE(tree->perm);
+    FREE(tree->pos);
+    FREE(tree->dim);
+    FREE(tree->count);
+    FREE(tree->active);
+    free(tree);
+}
+
+void kdtree_reset(kdtree *tree) {
+    MEMSET(tree->active, 1, tree->num_nodes, char);
+    reset_counts(tree, 0, tree->num_nodes);
+}
+
+/**
+ * Updates the active counts in the path from the root to the node
+ */
+static void update_path(kdtree *tree, int node, int incr) {
+    int target = tree->pos[node];
+    int lo = 0;
+    int hi = tree->num_nodes;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        tree->count[mid] += incr;
+        if (target == mid) break;
+        if (target < mid) { hi = mid; } else { lo = mid + 1; }
+    }
+}
+
+void kdtree_remove(kdtree *tree, int node) {
+    if (!tree->active[node]) return;
+    tree->active[node] = 0;
+    update_path(tree, node, -1);
+}
+
+void kdtree_insert(kdtree *tree, int node) {
+    if (tree->active[node]) return;
+    tree->active[node] = 1;
+    update_path(tree, node, 1);
+}
+
+/**
+ * Inserts a node in the sorted list of the neighbours found so far if it is near enough
+ */
+static void offer(knn_query *query, int node, double dist) {
+    if (query->found == query->k && dist >= query->sqdist[query->k - 1]) return;
+    int i = query->found < query->k ? query->found++ : query->k - 1;
+    while (i > 0 && query->sqdist[i - 1] > dist) {
+        query->sqdist[i] = query->sqdist[i - 1];
+        query->neighbours[i] = query->neighbours[i - 1];
+        i--;
+    }
+    query->sqdist[i] = dist;
+    query->neighbours[i] = node;
+}
+
+static void search(kdtree *tree, knn_query *query, int lo, int hi) {
+    if (lo >= hi) return;
+    int mid = (lo + hi) / 2;
+    if (tree->count[mid] == 0) return; // No active nodes in this subtree
+    int node = tree->perm[mid];
+    point p = tree->nodes[node];
+    if (tree->active[node] && node != query->query) {
+        offer(query, node, sqdistance(query->q, p));
+    }
+    double diff = coord(query->q, tree->dim[mid]) - coord(p, tree->dim[mid]);
+    // Visits first the side of the splitting line where the query node lies
+    if (diff < 0) {
+        search(tree, query, lo, mid);
+        if (query->found < query->k || diff * diff < query->sqdist[query->k - 1]) search(tree, query, mid + 1, hi);
+    } else {
+        search(tree, query, mid + 1, hi);
+        if (query->found < query->k || diff * diff < query->sqdist[query->k - 1]) search(tree, query, lo, mid);
+    }
+}
+
+int kdtree_knn(kdtree *tree, int node, int k, int *neighbours, double *sqdist) {
+    if (k <= 0) return 0;
+    double *dists = sqdist ? sqdist : MALLOC(k, double);
+    knn_query query = {.query = node, .q = tree->nodes[node], .k = k, .found = 0, .neighbours = neighbours, .sqdist = dists};
+    search(tree, &query, 0, tree->num_nodes);
+    if (!sqdist) { FREE(dists); }
+    return query.found;
+}
+
+int kdtree_nearest(kdtree *tree, int node) {
+    int nearest = -1;
+    double dist;
+    kdtree_knn(tree, node, 1, &nearest, &dist);
+    return nearest;
+}
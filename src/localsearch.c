@@ -0,0 +1,306 @@
+#include "localsearch.h"
+
+#include "distutil.h"
+#include "candidates.h"
+
+local_search* ls_create(instance *inst) {
+    int n = inst->num_nodes;
+    local_search *ls = MALLOC(1, local_search);
+    ls->inst = inst;
+    ls->num_nodes = n;
+    ls->cand = get_candidate_lists(inst);
+    ls->tour = MALLOC(n, int);
+    ls->pos = MALLOC(n, int);
+    for (int i = 0; i < n; i++) {
+        ls->tour[i] = i;
+        ls->pos[i] = i;
+    }
+    ls->queue = MALLOC(n, int);
+    ls->queue_head = 0;
+    ls->queue_size = 0;
+    ls->in_queue = CALLOC(n, char);
+    ls->undo_capacity = 1024;
+    ls->undo_log = MALLOC(ls->undo_capacity, int);
+    ls->undo_size = 0;
+    ls->logging = 0;
+    ls->cost = NULL;
+    ls->cost_data = NULL;
+    return ls;
+}
+
+void ls_free(local_search *ls) {
+    if (ls == NULL) return;
+    FREE(ls->tour);
+    FREE(ls->pos);
+    FREE(ls->queue);
+    FREE(ls->in_queue);
+    FREE(ls->undo_log);
+    FREE(ls);
+}
+
+void ls_set_cost(local_search *ls, ls_cost_fn cost, void *data) {
+    ls->cost = cost;
+    ls->cost_data = data;
+}
+
+double ls_edge_cost(const local_search *ls, int i, int j) {
+    if (ls->cost != NULL) return ls->cost(i, j, ls->cost_data);
+    return calc_dist(i, j, ls->inst);
+}
+
+/**
+ * Empties the queue and the undo log
+ */
+static void reset_state(local_search *ls) {
+    while (ls->queue_size > 0) {
+        ls->in_queue[ls->queue[ls->queue_head]] = 0;
+        ls->queue_head = (ls->queue_head + 1) % ls->num_nodes;
+        ls->queue_size--;
+    }
+    ls->queue_head = 0;
+    ls->undo_size = 0;
+    ls->logging = 0;
+}
+
+void ls_load(local_search *ls, const int *order) {
+    for (int i = 0; i < ls->num_nodes; i++) {
+        ls->tour[i] = order[i];
+        ls->pos[order[i]] = i;
+    }
+    reset_state(ls);
+}
+
+int ls_load_edges(local_search *ls, const edge *edges) {
+    int n = ls->num_nodes;
+    MEMSET(ls->pos, -1, n, int);
+    int node = 0;
+    for (int i = 0; i < n; i++) {
+        if (node < 0 || node >= n || ls->pos[node] >= 0) return 1; // Not a tour: a node is missing or visited twice
+        ls->tour[i] = node;
+        ls->pos[node] = i;
+        node = edges[node].j;
+    }
+    reset_state(ls);
+    return node != 0;
+}
+
+void ls_store(const local_search *ls, int *order) {
+    memcpy(order, ls->tour, ls->num_nodes * sizeof(int));
+}
+
+void ls_store_edges(const local_search *ls, edge *edges) {
+    int n = ls->num_nodes;
+    for (int i = 0; i < n; i++) {
+        int node = ls->tour[i];
+        edges[node].i = node;
+        edges[node].j = ls->tour[(i + 1) % n];
+    }
+}
+
+double ls_tour_cost(const local_search *ls) {
+    double cost = 0;
+    int n = ls->num_nodes;
+    for (int i = 0; i < n; i++) {
+        cost += ls_edge_cost(ls, ls->tour[i], ls->tour[(i + 1) % n]);
+    }
+    return cost;
+}
+
+int ls_succ(const local_search *ls, int node) {
+    int p = ls->pos[node] + 1;
+    return ls->tour[p == ls->num_nodes ? 0 : p];
+}
+
+int ls_pred(const local_search *ls, int node) {
+    int p = ls->pos[node];
+    return ls->tour[p == 0 ? ls->num_nodes - 1 : p - 1];
+}
+
+void ls_queue_node(local_search *ls, int node) {
+    if (ls->in_queue[node]) return;
+    ls->in_queue[node] = 1;
+    ls->queue[(ls->queue_head + ls->queue_size) % ls->num_nodes] = node;
+    ls->queue_size++;
+}
+
+void ls_queue_all(local_search *ls) {
+    for (int i = 0; i < ls->num_nodes; i++) { ls_queue_node(ls, ls->tour[i]); }
+}
+
+/**
+ * Reverses exactly the positions from i to j (cyclic and inclusive)
+ */
+static void reverse_positions(local_search *ls, int i, int j) {
+    int n = ls->num_nodes;
+    int len = (j - i + n) % n + 1;
+    for (int k = 0; k < len / 2; k++) {
+        int a = i + k; if (a >= n) a -= n;
+        int b = j - k; if (b < 0) b += n;
+        int node_a = ls->tour[a];
+        int node_b = ls->tour[b];
+        ls->tour[a] = node_b;
+        ls->pos[node_b] = a;
+        ls->tour[b] = node_a;
+        ls->pos[node_a] = b;
+    }
+}
+
+/**
+ * Reverses the path from position i to position j. The complementary path is reversed when it is shorter,
+ * since the resulting cyclic tour is the same. The reversal is logged when logging is active
+ */
+static void reverse_path_positions(local_search *ls, int i, int j) {
+    int n = ls->num_nodes;
+    int len = (j - i + n) % n + 1;
+    if (2 * len > n) {
+        int tmp = i;
+        i = (j + 1) % n;
+        j = (tmp - 1 + n) % n;
+    }
+    if (ls->logging) {
+        if (ls->undo_size + 2 > ls->undo_capacity) {
+            ls->undo_capacity *= 2;
+            ls->undo_log = REALLOC(ls->undo_log, ls->undo_capacity, int);
+        }
+        ls->undo_log[ls->undo_size++] = i;
+        ls->undo_log[ls->undo_size++] = j;
+    }
+    reverse_positions(ls, i, j);
+}
+
+double ls_2opt_move(local_search *ls, int a, int b, int c, int d) {
+    double delta = ls_edge_cost(ls, a, c) + ls_edge_cost(ls, b, d) - ls_edge_cost(ls, a, b) - ls_edge_cost(ls, c, d);
+    if (ls_succ(ls, a) == b) {
+        reverse_path_positions(ls, ls->pos[b], ls->pos[c]); // a b ... c d  ->  a c ... b d
+    } else {
+        reverse_path_positions(ls, ls->pos[c], ls->pos[b]); // d c ... b a  ->  d b ... c a
+    }
+    ls_queue_node(ls, a);
+    ls_queue_node(ls, b);
+    ls_queue_node(ls, c);
+    ls_queue_node(ls, d);
+    return delta;
+}
+
+/**
+ * Looks for an improving 2-opt move which replaces one of the two edges of node a with an edge to one of its candidates
+ *
+ * @returns The cost change of the applied move. 0 when no improving move is found
+ */
+static double improve_2opt(local_search *ls, int a) {
+    int k = ls->cand->k;
+    const int *neighbours = &(ls->cand->neighbours[(long) a * k]);
+    for (int dir = 0; dir < 2; dir++) {
+        int b = dir == 0 ? ls_succ(ls, a) : ls_pred(ls, a);
+        double d_ab = ls_edge_cost(ls, a, b);
+        for (int h = 0; h < k; h++) {
+            int c = neighbours[h];
+            double d_ac = ls_edge_cost(ls, a, c);
+            if (d_ac >= d_ab) continue; // The new edge must be shorter than the removed one
+            int d = dir == 0 ? ls_succ(ls, c) : ls_pred(ls, c);
+            if (c == b || d == a) continue;
+            double delta = d_ac + ls_edge_cost(ls, b, d) - d_ab - ls_edge_cost(ls, c, d);
+            if (delta < -EPS) {
+                return ls_2opt_move(ls, a, b, c, d);
+            }
+        }
+    }
+    return 0;
+}
+
+double ls_move_segment(local_search *ls, int s1, int s2, int t1, int t2, int reversed) {
+    int p = ls_pred(ls, s1);
+    int nx = ls_succ(ls, s2);
+    double delta = ls_2opt_move(ls, p, s1, t1, t2);                 // p t1 ... nx s2 ... s1 t2
+    if (t1 != nx) { delta += ls_2opt_move(ls, p, t1, nx, s2); }     // p nx ... t1 s2 ... s1 t2
+    if (!reversed && s1 != s2) { delta += ls_2opt_move(ls, t1, s2, s1, t2); } // t1 s1 ... s2 t2
+    return delta;
+}
+
+/**
+ * Looks for an improving Or-opt move of a segment of 1 to 3 nodes which starts or ends in node v.
+ * The segment is moved next to one of the candidates of its endpoints
+ *
+ * @returns The cost change of the applied move. 0 when no improving move is found
+ */
+static double improve_oropt(local_search *ls, int v) {
+    int n = ls->num_nodes;
+    int k = ls->cand->k;
+    for (int len = 1; len <= 3 && len + 3 <= n; len++) {
+        for (int side = 0; side < 2; side++) {
+            if (len == 1 && side == 1) continue; // Same segment of side 0
+            // The segment s1 ... s2 in tour direction
+            int s1 = v, s2 = v;
+            for (int h = 1; h < len; h++) {
+                if (side == 0) { s2 = ls_succ(ls, s2); }
+                else { s1 = ls_pred(ls, s1); }
+            }
+            int p = ls_pred(ls, s1);
+            int nx = ls_succ(ls, s2);
+            int mid = len == 3 ? ls_succ(ls, s1) : s1;
+            double gain = ls_edge_cost(ls, p, s1) + ls_edge_cost(ls, s2, nx) - ls_edge_cost(ls, p, nx);
+            if (gain <= EPS) continue;
+
+            for (int end = 0; end < 2; end++) {
+                int x = end == 0 ? s1 : s2;
+                const int *neighbours = &(ls->cand->neighbours[(long) x * k]);
+                for (int h = 0; h < k; h++) {
+                    int c = neighbours[h];
+                    if (c == s1 || c == s2 || c == mid) continue;
+                    if (ls_edge_cost(ls, x, c) >= gain) continue;
+                    for (int dir = 0; dir < 2; dir++) {
+                        // The edge (t1, t2) where t2 follows t1
+                        int t1 = dir == 0 ? c : ls_pred(ls, c);
+                        int t2 = dir == 0 ? ls_succ(ls, c) : c;
+                        if (t1 == s1 || t1 == s2 || t1 == mid || t2 == s1 || t2 == s2 || t2 == mid || t2 == p) continue;
+                        double removed = ls_edge_cost(ls, t1, t2);
+                        double add_fwd = ls_edge_cost(ls, t1, s1) + ls_edge_cost(ls, s2, t2) - removed;
+                        double add_rev = ls_edge_cost(ls, t1, s2) + ls_edge_cost(ls, s1, t2) - removed;
+                        int reversed = add_rev < add_fwd;
+                        double delta = (reversed ? add_rev : add_fwd) - gain;
+                        if (delta < -EPS) {
+                            return ls_move_segment(ls, s1, s2, t1, t2, reversed);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+double ls_optimize(local_search *ls) {
+    double total = 0;
+    while (ls->queue_size > 0) {
+        int v = ls->queue[ls->queue_head];
+        ls->queue_head = (ls->queue_head + 1) % ls->num_nodes;
+        ls->queue_size--;
+        ls->in_queue[v] = 0;
+
+        double delta = improve_2opt(ls, v);
+        if (delta == 0) { delta = improve_oropt(ls, v); }
+        if (delta < 0) {
+            total += delta;
+            ls_queue_node(ls, v);
+        }
+    }
+    return total;
+}
+
+int ls_mark(local_search *ls) {
+    ls->logging = 1;
+    return ls->undo_size;
+}
+
+void ls_undo(local_search *ls, int mark) {
+    for (int h = ls->undo_size - 2; h >= mark; h -= 2) {
+        reverse_positions(ls, ls->undo_log[h], ls->undo_log[h + 1]);
+    }
+    ls->undo_size = mark;
+    ls->logging = 0;
+}
+
+void ls_commit(local_search *ls) {
+    ls->undo_size = 0;
+    ls->logging = 0;
+}
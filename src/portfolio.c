@@ -0,0 +1,265 @@
+#include "portfolio.h"
+
+#include "heuristics.h"
+#include "distutil.h"
+#include "candidates.h"
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+////////////////////////////////////////////////////////
+///////////////// HYPERPARAMETERS //////////////////////
+////////////////////////////////////////////////////////
+#define DEFAULT_PORTFOLIO "2OPT_GRASP_ITER,VNS,TABU_REACTIVE,GENETIC" // The methods raced when -portfolio is not given
+#define SLICE_RATE 10 // The length of a time slice in percentage of the time limit. A slice lasts at least one second
+
+
+// A method of the portfolio
+typedef struct {
+    const char *name;       // The name given in the portfolio list
+    instance scratch;       // The instance on which the method runs. It shares the problem data and owns its solution
+    int *tour;              // Work memory: the tour from which a slice starts and then the tour it finds
+    int *best_tour;         // The best tour found by the method in visiting order
+    double best_obj;
+    rng_state rng;          // It draws the seed of each slice
+    atomic_int busy;        // 1 while a worker runs a slice of this method
+
+    // Statistics
+    int slices;
+    int updates;            // The number of times the method improved the incumbent
+    double time_to_best;    // When the method found its best tour
+    double run_time;        // The total time of its slices
+} portfolio_member;
+
+// The data shared by the workers of the pool
+typedef struct {
+    instance *inst;
+    int (*solve)(instance *);
+    portfolio_member *members;
+    int num_members;
+    atomic_int next;            // The ticket of the next method to run
+    atomic_int stop;            // 1 when the time limit or the target objective is reached
+    atomic_int target_reached;  // 1 when the run stopped at the target objective
+    struct timeval start;
+    double time_limit;
+    int slice;                  // The length of a time slice in seconds
+
+    _Atomic double best_obj;    // The cost of the incumbent. It is read without locking
+    int *best_tour;             // The incumbent in visiting order
+    pthread_mutex_t mutex;      // Protects the incumbent tour
+} portfolio_shared;
+
+/**
+ * Stores the tour found by a slice in visiting order
+ *
+ * @returns The cost of the tour. DBL_MAX if the successors of the solution are not a tour
+ */
+static double read_tour(instance *scratch, int *tour) {
+    int n = scratch->num_nodes;
+    double cost = 0;
+    int node = 0;
+    for (int pos = 0; pos < n; pos++) {
+        if (pos > 0 && node == 0) return DBL_MAX;
+        tour[pos] = node;
+        int next = scratch->solution.edges[node].j;
+        if (next < 0 || next >= n) return DBL_MAX;
+        cost += calc_dist(node, next, scratch);
+        node = next;
+    }
+    return node == 0 ? cost : DBL_MAX;
+}
+
+/**
+ * Runs a time slice of a method. It starts from the incumbent if it is better than the best tour of the method
+ */
+static void run_slice(portfolio_shared *shared, portfolio_member *member) {
+    instance *inst = shared->inst;
+    int n = inst->num_nodes;
+    struct timeval now;
+    gettimeofday(&now, 0);
+    double remaining = shared->time_limit - get_elapsed_time(shared->start, now);
+    if (remaining <= 0) {
+        atomic_store(&(shared->stop), 1);
+        return;
+    }
+
+    //Choose the starting tour
+    instance *scratch = &(member->scratch);
+    scratch->warm_start = NULL;
+    if (atomic_load(&(shared->best_obj)) < member->best_obj - EPS) {
+        pthread_mutex_lock(&(shared->mutex));
+        memcpy(member->tour, shared->best_tour, n * sizeof(int));
+        pthread_mutex_unlock(&(shared->mutex));
+        scratch->warm_start = member->tour;
+    } else if (member->best_obj < DBL_MAX) {
+        scratch->warm_start = member->best_tour;
+    }
+
+    int slice = shared->slice < remaining ? shared->slice : (int) ceil(remaining);
+    scratch->params.time_limit = slice;
+    scratch->params.grasp_time_lim = slice;
+    scratch->params.seed = (int) (rng_next(&(member->rng)) & 0x7FFFFFFF);
+    rng_seed(&(scratch->rng), scratch->params.seed, 0);
+
+    struct timeval start;
+    gettimeofday(&start, 0);
+    shared->solve(scratch);
+    gettimeofday(&now, 0);
+    member->slices++;
+    member->run_time += get_elapsed_time(start, now);
+    double elapsed = get_elapsed_time(shared->start, now);
+
+    double cost = read_tour(scratch, member->tour);
+    if (cost == DBL_MAX) {
+        if (inst->params.verbose >= 3) {LOG_I("%s did not return a tour", member->name);}
+        return;
+    }
+    if (inst->params.verbose >= 4) {LOG_I("%s slice %d: %0.0f", member->name, member->slices, cost);}
+    if (cost < member->best_obj - EPS) {
+        member->best_obj = cost;
+        memcpy(member->best_tour, member->tour, n * sizeof(int));
+        member->time_to_best = elapsed;
+    }
+
+    //Publish the tour if it improves the incumbent
+    if (cost < atomic_load(&(shared->best_obj)) - EPS) {
+        pthread_mutex_lock(&(shared->mutex));
+        if (cost < atomic_load(&(shared->best_obj)) - EPS) {
+            memcpy(shared->best_tour, member->tour, n * sizeof(int));
+            atomic_store(&(shared->best_obj), cost);
+            member->updates++;
+            if (inst->params.verbose >= 3) {LOG_I("Updated incumbent by %s after %0.2fs: %0.0f", member->name, elapsed, cost);}
+        }
+        pthread_mutex_unlock(&(shared->mutex));
+    }
+    if (inst->params.target_obj >= 0 && cost <= inst->params.target_obj + EPS) {
+        atomic_store(&(shared->target_reached), 1);
+        atomic_store(&(shared->stop), 1);
+    }
+}
+
+/**
+ * The loop of a worker of the pool: it runs a slice of the next method which is not running on another worker
+ */
+static void* portfolio_worker(void *arg) {
+    portfolio_shared *shared = (portfolio_shared*) arg;
+    while (!atomic_load(&(shared->stop))) {
+        int ticket = atomic_fetch_add(&(shared->next), 1);
+        portfolio_member *member = &(shared->members[ticket % shared->num_members]);
+        if (atomic_exchange(&(member->busy), 1)) continue;
+        run_slice(shared, member);
+        atomic_store(&(member->busy), 0);
+    }
+    return NULL;
+}
+
+int HEU_Portfolio(instance *inst, int (*solve)(instance *)) {
+    int n = inst->num_nodes;
+    portfolio_shared shared;
+    shared.inst = inst;
+    shared.solve = solve;
+
+    //Set time limit
+    if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {LOG_I("Default time lim %d set.", DEFAULT_TIME_LIM);}
+    shared.time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+    shared.slice = (int) (shared.time_limit * SLICE_RATE / 100);
+    if (shared.slice < 1) { shared.slice = 1; }
+
+    //The candidate lists are built on demand, so they are built now and the methods share them
+    get_candidate_lists(inst);
+
+    //Parse the methods of the portfolio
+    const char *list = inst->params.portfolio != NULL ? inst->params.portfolio : DEFAULT_PORTFOLIO;
+    char *names = MALLOC((strlen(list) + 1), char);
+    strcpy(names, list);
+    int max_members = 1;
+    for (const char *c = list; *c != '\0'; c++) {
+        if (*c == ',') { max_members++; }
+    }
+    shared.members = CALLOC(max_members, portfolio_member);
+    shared.num_members = 0;
+    char *saveptr = NULL;
+    for (char *name = strtok_r(names, ",", &saveptr); name != NULL; name = strtok_r(NULL, ",", &saveptr)) {
+        instance_params params = inst->params;
+        if (!parse_method(name, &params)) {LOG_E("Unknown method %s in the portfolio", name);}
+        if (params.method.use_cplex || params.method.id == SOLVE_PORTFOLIO) {LOG_E("The portfolio accepts only heuristics. %s is not allowed", name);}
+
+        //The scratch instance shares the problem data with the instance and owns the solution
+        portfolio_member *member = &(shared.members[shared.num_members]);
+        member->name = name;
+        member->scratch = *inst;
+        member->scratch.params.method = params.method;
+        member->scratch.params.num_threads = 1;
+        member->scratch.params.perf_prof = 1; // No plots and no files
+        member->scratch.params.verbose = inst->params.verbose >= 5 ? 3 : -1;
+        member->scratch.ind = NULL;
+        member->scratch.thread_rngs = NULL;
+        member->scratch.solution.edges = CALLOC(n, edge);
+        member->scratch.solution.xbest = NULL;
+        member->tour = MALLOC(n, int);
+        member->best_tour = MALLOC(n, int);
+        member->best_obj = DBL_MAX;
+        rng_seed(&(member->rng), inst->params.seed, shared.num_members + 1);
+        atomic_init(&(member->busy), 0);
+        shared.num_members++;
+    }
+    if (shared.num_members == 0) {LOG_E("The portfolio is empty");}
+
+    shared.best_tour = MALLOC(n, int);
+    atomic_init(&(shared.best_obj), DBL_MAX);
+    atomic_init(&(shared.next), 0);
+    atomic_init(&(shared.stop), 0);
+    atomic_init(&(shared.target_reached), 0);
+    pthread_mutex_init(&(shared.mutex), NULL);
+
+    //Start the pool. It never has more workers than methods
+    int num_threads = get_num_threads(inst);
+    if (num_threads > shared.num_members) { num_threads = shared.num_members; }
+    if (inst->params.verbose >= 3) {LOG_I("Portfolio of %d methods on %d threads, slices of %ds", shared.num_members, num_threads, shared.slice);}
+    gettimeofday(&(shared.start), 0);
+    pthread_t *threads = MALLOC(num_threads, pthread_t);
+    for (int i = 1; i < num_threads; i++) {
+        pthread_create(&(threads[i]), NULL, portfolio_worker, &shared);
+    }
+    portfolio_worker(&shared); // The main thread is a worker too
+    for (int i = 1; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (inst->params.verbose >= 1) {
+        for (int m = 0; m < shared.num_members; m++) {
+            portfolio_member *member = &(shared.members[m]);
+            LOG_I("%-20s slices: %4d  best: %12.0f  incumbent updates: %4d  time to best: %8.2fs  run time: %8.2fs",
+                member->name, member->slices, member->best_obj, member->updates, member->time_to_best, member->run_time);
+        }
+    }
+
+    //Store the incumbent
+    int status = atomic_load(&(shared.target_reached)) ? 0 : TIME_LIMIT_EXCEEDED;
+    double best_obj = atomic_load(&(shared.best_obj));
+    if (best_obj < DBL_MAX) {
+        for (int pos = 0; pos < n; pos++) {
+            int i = shared.best_tour[pos];
+            inst->solution.edges[i].i = i;
+            inst->solution.edges[i].j = shared.best_tour[pos + 1 < n ? pos + 1 : 0];
+        }
+        inst->solution.obj_best = best_obj;
+    } else {
+        status = HEU_greedy(inst);
+    }
+
+    // Free allocations
+    for (int m = 0; m < shared.num_members; m++) {
+        FREE(shared.members[m].scratch.solution.edges);
+        FREE(shared.members[m].tour);
+        FREE(shared.members[m].best_tour);
+    }
+    pthread_mutex_destroy(&(shared.mutex));
+    FREE(shared.members);
+    FREE(shared.best_tour);
+    FREE(threads);
+    FREE(names);
+    return status;
+}
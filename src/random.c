@@ -0,0 +1,69 @@
+#include "random.h"
+
+static inline uint64_t rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Used only to expand the 64 bit seed into the 256 bit state of xoshiro
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Advances the generator of 2^128 steps. Used to create non overlapping streams
+ *
+ * @param rng The generator state
+ */
+static void rng_jump(rng_state *rng) {
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (JUMP[i] & ((uint64_t) 1) << b) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            rng_next(rng);
+        }
+    }
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
+
+void rng_seed(rng_state *rng, uint64_t seed, uint64_t stream) {
+    uint64_t x = seed;
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&x);
+    }
+    for (uint64_t i = 0; i < stream; i++) {
+        rng_jump(rng);
+    }
+}
+
+uint64_t rng_next(rng_state *rng) {
+    uint64_t *s = rng->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+double rng_urand(rng_state *rng) {
+    // The 53 most significant bits are used to build a double in [0, 1)
+    return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
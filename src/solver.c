@@ -11,10 +11,17 @@
 #include "callback.h"
 #include "hardfixing.h"
 #include "softfixing.h"
+#include "tourmerge.h"
 #include "heuristics.h"
 #include "tabusearch.h"
 #include "genetic.h"
+#include "annealing.h"
+#include "aco.h"
+#include "alns.h"
+#include "gls.h"
+#include "portfolio.h"
 #include "vns.h"
+#include "spacecurve.h"
 
 // BEST SOLVER: USER CUT SOLVER
 int configure_opt_best_solver(CPXENVptr env, CPXLPptr lp, instance *inst) {
@@ -59,7 +66,7 @@ static void print_solution(instance *inst) {
 
             for ( int i = 0; i < inst->num_nodes; i++ ){
                 edge e = inst->solution.edges[i];
-                LOG_I("x(%3d,%3d) = 1", e.i+1,e.j+1);
+                LOG_I("x(%3d,%3d) = 1", original_id(inst, e.i) + 1, original_id(inst, e.j) + 1);
             }
         }
 
@@ -98,6 +105,8 @@ static int solve_problem(CPXENVptr env, CPXLPptr lp, instance *inst) {
         status = hard_fixing_solver2(inst, env, lp);
     } else if (method == SOLVE_SOFT_FIXING) {
         status = soft_fixing_solver(inst, env, lp);
+    } else if (method == SOLVE_TOUR_MERGE) {
+        status = tour_merge_solver(inst, env, lp);
     } else if (method == SOLVE_CALLBACK || method == SOLVE_UCUT) {
         CPXLONG contextid = CPX_CALLBACKCONTEXT_CANDIDATE;
         if (inst->params.method.id == SOLVE_UCUT) {
@@ -133,6 +142,14 @@ static int solve_problem_HEUC(instance *inst) {
         status = HEU_2opt_greedy_iter(inst);
     } else if (inst->params.method.id == SOLVE_2OPT_EXTR_MIL) {
         status = HEU_2opt_extramileage(inst);
+    } else if (inst->params.method.id == SOLVE_SAVINGS) {
+        status = HEU_Savings(inst);
+    } else if (inst->params.method.id == SOLVE_2OPT_SAVINGS) {
+        status = HEU_2opt_savings(inst);
+    } else if (inst->params.method.id == SOLVE_CHRISTOFIDES) {
+        status = HEU_Christofides(inst);
+    } else if (inst->params.method.id == SOLVE_2OPT_CHRISTOFIDES) {
+        status = HEU_2opt_christofides(inst);
     } else if (inst->params.method.id == SOLVE_VNS) {
         status = HEU_VNS(inst);
     } else if (inst->params.method.id == SOLVE_TABU_STEP) {
@@ -141,8 +158,20 @@ static int solve_problem_HEUC(instance *inst) {
         status = HEU_Tabu_lin(inst);
     } else if (inst->params.method.id == SOLVE_TABU_RAND) {
         status = HEU_Tabu_rand(inst);
+    } else if (inst->params.method.id == SOLVE_TABU_REACTIVE) {
+        status = HEU_Tabu_reactive(inst);
     } else if (inst->params.method.id == SOLVE_GENETIC) {
         status = HEU_Genetic(inst);
+    } else if (inst->params.method.id == SOLVE_SIMULATED_ANNEALING) {
+        status = HEU_Simulated_annealing(inst);
+    } else if (inst->params.method.id == SOLVE_ACO) {
+        status = HEU_ACO(inst);
+    } else if (inst->params.method.id == SOLVE_ALNS) {
+        status = HEU_ALNS(inst);
+    } else if (inst->params.method.id == SOLVE_GLS) {
+        status = HEU_GLS(inst);
+    } else if (inst->params.method.id == SOLVE_PORTFOLIO) {
+        status = HEU_Portfolio(inst, solve_problem_HEUC);
     }
     else {
         LOG_E("No Heuristic method specified!");
@@ -165,29 +194,24 @@ int TSP_opt(instance *inst) {
     save_cplex_log(env, inst);
 
     
-    if (inst->params.seed >= 0) {
-        srandom(inst->params.seed); // Setting the random seed for rand()
-    }
+    rng_seed(&(inst->rng), inst->params.seed, 0); // Stream 0 is the one of the main thread
     long ncols = CPXgetnumcols(env, lp);
     inst->num_columns = ncols; // The callbacks need the number of cols
     inst->solution.edges = CALLOC(inst->num_nodes, edge);
 
     // Setting up indices array. Setting up it here avoids on setting it up everytime the 2-opt callback need it. One time initialization and that's all.
+    // The columns are numbered as x_udir_pos numbers the edges, so the index of each column is its position
     inst->ind = MALLOC(inst->num_columns, int);
-    int k = 0;
-    for (int i = 0; i < inst->num_nodes - 1; i++) {
-        for (int j = i + 1; j < inst->num_nodes; j++) {
-            inst->ind[k++] = x_udir_pos(i, j, inst->num_nodes);
-        }
+    for (int k = 0; k < inst->num_columns; k++) {
+        inst->ind[k] = k;
     }
     // setting up seeds array for multithreading methods
     // As cplex's documentations says, the maximal number of threads used by cplex is 32 if not specified a higher number
     // Check it here: https://www.ibm.com/docs/en/icos/12.8.0.0?topic=parameters-global-thread-count
     int max_threads = inst->params.num_threads > 32 ? inst->params.num_threads : 32;
-    inst->thread_seeds = CALLOC(max_threads, unsigned int);
+    inst->thread_rngs = CALLOC(max_threads, rng_state);
     for (int i = 0; i < max_threads; i++) {
-        unsigned int seed = (unsigned int) time(NULL);
-        inst->thread_seeds[i] = seed ^ (i+1);//(seed & 0xFFFFFFF0) | (i + 1);
+        rng_seed(&(inst->thread_rngs[i]), inst->params.seed, i + 1); // Each thread has its own stream
     }
 
     //Start counting time
@@ -243,7 +267,7 @@ int TSP_opt(instance *inst) {
     plot_solution(inst);
 
     if (inst->params.perf_prof) {
-        if (inst->params.method.id == SOLVE_HARD_FIXING || inst->params.method.id == SOLVE_HARD_FIXING2 || inst->params.method.id == SOLVE_SOFT_FIXING) {
+        if (inst->params.method.id == SOLVE_HARD_FIXING || inst->params.method.id == SOLVE_HARD_FIXING2 || inst->params.method.id == SOLVE_SOFT_FIXING || inst->params.method.id == SOLVE_TOUR_MERGE) {
             printf("%0.2f", inst->solution.obj_best);
         } else {
             printf("%0.6f", elapsed);
@@ -261,9 +285,10 @@ int TSP_opt(instance *inst) {
 
 int TSP_heuc(instance *inst) {
 
-    if (inst->params.seed >= 0) {
-        srandom(inst->params.seed); // Setting the random seed for rand()
-    }
+    rng_seed(&(inst->rng), inst->params.seed, 0); // Stream 0 is the one of the main thread
+
+    // Spatially near nodes get near indices, so the heuristics access memory with good locality on large instances
+    if (inst->params.renumber) { renumber_nodes(inst); }
 
     // In heuristic xbest is not used since it's a quadratic data structure. Since heuristics solves very large problems, the amount of memory required by xbest is very huge
     inst->num_columns = (long) inst->num_nodes * (inst->num_nodes - 1) / 2; 
@@ -416,6 +441,9 @@ static void build_dir_model(instance *inst, CPXENVptr env, CPXLPptr lp) {
 
 static void build_model(instance *inst, CPXENVptr env, CPXLPptr lp) {
 
+    // The tour merging model contains only the edges of the heuristic tours, so it is built by the solver once it has them
+    if (inst->params.method.id == SOLVE_TOUR_MERGE) return;
+
     // Checks the type of the edge in order to build the correct model
     if (inst->params.method.edge_type == UDIR_EDGE) {
         // Builds naive model for undirected graphs
@@ -0,0 +1,86 @@
+#include "spacecurve.h"
+
+#include <float.h>
+#include <math.h>
+#include "candidates.h"
+
+#define HILBERT_ORDER 16 // Grid of 65536 x 65536 cells
+
+typedef struct {
+    uint64_t key;
+    int node;
+} curve_entry;
+
+static int compare_curve_entries(const void *a, const void *b) {
+    const curve_entry *e1 = (const curve_entry*) a;
+    const curve_entry *e2 = (const curve_entry*) b;
+    if (e1->key != e2->key) return e1->key < e2->key ? -1 : 1;
+    return e1->node - e2->node; // Ties keep the file order
+}
+
+uint64_t hilbert_index(uint32_t x, uint32_t y, int order) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << (order - 1); s > 0; s >>= 1) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += (uint64_t) s * s * ((3 * rx) ^ ry);
+        // Rotation of the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            uint32_t tmp = x;
+            x = y;
+            y = tmp;
+        }
+        x &= s - 1;
+        y &= s - 1;
+    }
+    return d;
+}
+
+void renumber_nodes(instance *inst) {
+    int n = inst->num_nodes;
+    if (n <= 0 || inst->original_ids != NULL) return;
+
+    double min_x = DBL_MAX, min_y = DBL_MAX, max_x = -DBL_MAX, max_y = -DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        min_x = fmin(min_x, inst->nodes[i].x);
+        max_x = fmax(max_x, inst->nodes[i].x);
+        min_y = fmin(min_y, inst->nodes[i].y);
+        max_y = fmax(max_y, inst->nodes[i].y);
+    }
+    // The same scale is used on both axes in order to preserve the shape of the instance
+    double span = fmax(max_x - min_x, max_y - min_y);
+    double scale = span > 0 ? ((1u << HILBERT_ORDER) - 1) / span : 0;
+
+    curve_entry *entries = MALLOC(n, curve_entry);
+    for (int i = 0; i < n; i++) {
+        uint32_t x = (uint32_t) ((inst->nodes[i].x - min_x) * scale);
+        uint32_t y = (uint32_t) ((inst->nodes[i].y - min_y) * scale);
+        entries[i].key = hilbert_index(x, y, HILBERT_ORDER);
+        entries[i].node = i;
+    }
+    qsort(entries, n, sizeof(curve_entry), compare_curve_entries);
+
+    point *nodes = MALLOC(n, point);
+    inst->original_ids = MALLOC(n, int);
+    for (int i = 0; i < n; i++) {
+        nodes[i] = inst->nodes[entries[i].node];
+        inst->original_ids[i] = entries[i].node;
+    }
+    FREE(inst->nodes);
+    inst->nodes = nodes;
+    FREE(entries);
+
+    // The structures indexed by node built on the old numbering are not valid anymore
+    free_candidate_lists(inst->candidates);
+    inst->candidates = NULL;
+
+    if (inst->params.verbose >= 3) {LOG_I("Nodes renumbered along the Hilbert curve");}
+}
+
+int original_id(const instance *inst, int node) {
+    return inst->original_ids != NULL ? inst->original_ids[node] : node;
+}
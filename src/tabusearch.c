@@ -2,8 +2,15 @@
 
 #include "heuristics.h"
 #include "distutil.h"
+#include "localsearch.h"
+#include "heap.h"
+#include "candidates.h"
+#include "elite.h"
+#include "edgemap.h"
 #include <unistd.h>
 #include <float.h>
+#include <pthread.h>
+#include <stdint.h>
 
 ////////////////////////////////////////////////////////
 ///////////////// HYPERPARAMETERS //////////////////////
@@ -11,6 +18,15 @@
 #define NUM_ITER 100 // It' the number of iterations where the tenure changes (step and rand policy)
 #define MIN_TENURE_RATE 0.02 // The size of min tenure in percentage with the number of nodes. If the problem has 100 nodes and the rate is 0.02, min tenure will have a value od 2
 #define MAX_TENURE_RATE 0.1 // The size of max tenure in percentage with the number of nodes. If the problem has 100 nodes and the rate is 0.1, max tenure will have a value od 10
+#define REFRESH_INTERVAL 100 // The number of iterations after which the cached moves of all the nodes are evaluated again
+#define ELITE_SIZE 10 // The number of tours in the elite pool shared by the trajectories
+#define STAGNATION_ITER 1000 // The number of iterations without improving its best tour after which a trajectory restarts from the elite pool
+#define RELINK_CHECKPOINTS 5 // The number of intermediate tours improved by the path relinking toward an elite tour before a restart
+#define REACTIVE_INCREASE 1.1 // The factor which increases the tenure when the reactive policy finds a local optimum already visited
+#define REACTIVE_DECREASE 0.9 // The factor which decreases the tenure when the reactive policy finds no repetition for a while
+#define REACTIVE_STABLE_ITER 100 // The number of iterations without repetitions after which the reactive policy decreases the tenure
+#define MAX_VISITED_OPTIMA (1 << 20) // The number of local optima remembered by a trajectory. The memory is cleared when full
+#define KICK_MAX_ATTEMPTS 4 // The attempts of a kick to find two edges which are not tabu, in multiples of the number of nodes. Then the tabu list is ignored
 
 // Struct used to keep track of the policy
 typedef struct {
@@ -18,8 +34,26 @@ typedef struct {
     int max_tenure;
     int current_tenure;
     int incr_tenure; // Variable for checking whether the tenure should increase or decrease in linear policy
+    rng_state *rng; // The random generator used by the randomized policies
+    int repeated; // Whether the last local optimum had already been visited. Used by the reactive policy
+    int last_change; // The last iteration in which the reactive policy changed the tenure
 } tenure_policy;
 
+// Tabu list of edges. It stores in a hash table keyed by edge the iteration in which each edge became tabu.
+// An entry expires when more than tenure iterations have passed, so only O(tenure) entries are alive
+// and the memory does not depend on the number of edges of the graph
+typedef struct {
+    edge_map *iters;    // The iteration in which each edge became tabu, including the expired entries not purged yet
+    int max_tenure;     // The maximum tenure of the policy. The entries younger than it are kept because the tenure can grow
+} tabu_list;
+
+// Set of the hashes of the local optima visited by a trajectory. It is an open addressing hash table
+typedef struct {
+    int capacity;       // The number of slots. It is a power of 2
+    int count;
+    uint64_t *keys;     // The hashes. 0 when the slot is empty
+} optima_set;
+
 ////////////////////////////////////////////////////////
 ///////////////// POLICIES /////////////////////////////
 ////////////////////////////////////////////////////////
@@ -67,255 +101,713 @@ static void linear_policy(tenure_policy *policy, int curr_iter) {
  */
 static void random_policy(tenure_policy *policy, int curr_iter) {
     if (curr_iter == 1 || curr_iter % NUM_ITER == 0) {
-        policy->current_tenure = rand_choice(policy->min_tenure, policy->max_tenure + 1); // + 1 because rand_choice doesn't include the right bound
+        policy->current_tenure = rand_choice(policy->min_tenure, policy->max_tenure + 1, policy->rng); // + 1 because rand_choice doesn't include the right bound
     } 
 }
 
-/** Check whether an edge is currently in tabu list or not. If the node has expired the tenure time,
- *  the node is removed from tabu list.
+/**
+ * Reactive policy callback: Tenure increases when the trajectory goes back to a local optimum already visited,
+ * i.e. when it is cycling, and decreases when no local optimum is repeated for REACTIVE_STABLE_ITER iterations
+ * 
+ * @param policy A pointer of tenure_policy
+ * @param curr_iter The current algorithm's iteration
+ */
+static void reactive_policy(tenure_policy *policy, int curr_iter) {
+    if (policy->repeated) {
+        int tenure = ceil(policy->current_tenure * REACTIVE_INCREASE);
+        policy->current_tenure = tenure < policy->max_tenure ? tenure : policy->max_tenure;
+        policy->last_change = curr_iter;
+    } else if (curr_iter - policy->last_change > REACTIVE_STABLE_ITER) {
+        int tenure = floor(policy->current_tenure * REACTIVE_DECREASE);
+        policy->current_tenure = tenure > policy->min_tenure ? tenure : policy->min_tenure;
+        policy->last_change = curr_iter;
+    }
+}
+
+////////////////////////////////////////////////////////
+///////////////// TABU LIST ////////////////////////////
+////////////////////////////////////////////////////////
+
+/**
+ * Allocates an empty tabu list
+ * 
+ * @param num_nodes The number of nodes in the instance
+ * @param max_tenure The maximum tenure of the policy. It is used to size the table, which grows if needed, and to purge it
+ * @returns The allocated tabu list
+ */
+static tabu_list* tabu_list_create(int num_nodes, int max_tenure) {
+    tabu_list *list = MALLOC(1, tabu_list);
+    list->iters = edge_map_create(num_nodes, 8 * (max_tenure + 1)); // Two edges become tabu in each iteration
+    list->max_tenure = max_tenure;
+    return list;
+}
+
+static void tabu_list_free(tabu_list *list) {
+    if (list == NULL) return;
+    edge_map_free(list->iters);
+    FREE(list);
+}
+
+// The data of tabu_entry_alive
+typedef struct {
+    int iter;
+    int tenure;
+} tabu_age;
+
+static int tabu_entry_alive(int value, void *data) {
+    tabu_age *age = (tabu_age*) data;
+    return age->iter - value <= age->tenure;
+}
+
+/**
+ * Makes the edge (i, j) tabu from the iteration iter. When the table is full, the entries older than the maximum
+ * tenure are purged first, since they cannot become tabu again when the tenure grows
  * 
- * @param edge_val A pointer of an edge's tabu value
+ * @param list The tabu list
+ * @param i The first node of the edge
+ * @param j The second node of the edge
+ * @param iter The algorithm's current iteration
+ */
+static void tabu_list_add(tabu_list *list, int i, int j, int iter) {
+    if (2 * (list->iters->count + 1) > list->iters->capacity) {
+        tabu_age age = {iter, list->max_tenure};
+        edge_map_filter(list->iters, tabu_entry_alive, &age);
+    }
+    edge_map_put(list->iters, i, j, iter);
+}
+
+/** Check whether an edge is currently in tabu list or not. An edge which has expired the tenure time is not tabu.
+ * 
+ * @param list The tabu list
+ * @param i The first node of the edge
+ * @param j The second node of the edge
  * @param iter The algorithm's current iteration
  * @param tenure The current tenure 
  * 
  * @returns true if the current edge is inside tabu list and should be skipped, 0 otherwise
  */
-int check_tenure(int* edge_val, const int iter, const int tenure) {
-    if (iter < 0 || tenure < 0) { return 0; }
-    if (*edge_val == 0) return 0;
-    if (iter - *edge_val > tenure) {
-        *edge_val = 0;
-        return 0;
+static int tabu_list_contains(const tabu_list *list, int i, int j, const int iter, const int tenure) {
+    if (list == NULL || iter < 0 || tenure < 0) { return 0; }
+    int tabu_iter;
+    if (!edge_map_get(list->iters, i, j, &tabu_iter)) return 0;
+    return iter - tabu_iter <= tenure;
+}
+
+////////////////////////////////////////////////////////
+///////////////// TOUR HASHING /////////////////////////
+////////////////////////////////////////////////////////
+
+// The Zobrist key of an edge is given by edge_zobrist in elite.h. The hash of a tour is the xor of the keys of
+// its edges and it is updated in O(1) after a move by removing and adding the keys of the changed edges
+
+static optima_set* optima_set_create() {
+    optima_set *set = MALLOC(1, optima_set);
+    set->capacity = 1024;
+    set->count = 0;
+    set->keys = CALLOC(set->capacity, uint64_t);
+    return set;
+}
+
+static void optima_set_free(optima_set *set) {
+    if (set == NULL) return;
+    FREE(set->keys);
+    FREE(set);
+}
+
+static void optima_set_put(optima_set *set, uint64_t key) {
+    int slot = (int) (key >> 40) & (set->capacity - 1);
+    while (set->keys[slot] != 0 && set->keys[slot] != key) {
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+    if (set->keys[slot] == 0) {
+        set->keys[slot] = key;
+        set->count++;
     }
-    
-    return 1;
 }
 
 /**
- * Applies 2-opt specifically designed for tabu search. It implements a skip procedure when it encounters
- * an edge in the tabu list.
- * 
- * @param inst The instance pointer of the problem
- * @param skip_edge The tabu list
- * @param stored_prev An array of the previous node for each node. It is useful for tabu when needs to reverse the path
- * of two swapped nodes outside of this function. This function indeed fullfils the stored_prev array
- * @param iter The algorithm's current iteration
- * @param tenure The current tenure
+ * Inserts the hash of a local optimum in the set
  * 
- * @returns The status code 0 when no errors occur
- */ 
-int alg_2opt_tabu(instance *inst, int *skip_edge, int *stored_prev, const int iter, const int tenure) {
-    struct timeval start, end;
-    gettimeofday(&start, 0);
-    double mindelta;
-    int status = 0;
-    int *prev = MALLOC(inst->num_nodes, int);
-    MEMSET(prev, -1, inst->num_nodes, int);
-    for (int i = 0; i < inst->num_nodes; i++) {
-        prev[inst->solution.edges[i].j] = i;
+ * @param set The set of the visited local optima
+ * @param hash The hash of the tour
+ * @returns 1 if the hash was already in the set, 0 otherwise
+ */
+static int optima_set_visit(optima_set *set, uint64_t hash) {
+    uint64_t key = hash == 0 ? 1 : hash; // 0 marks the empty slots
+    int slot = (int) (key >> 40) & (set->capacity - 1);
+    while (set->keys[slot] != 0) {
+        if (set->keys[slot] == key) return 1;
+        slot = (slot + 1) & (set->capacity - 1);
     }
-    int mina = 0;
-    int minb = 0;
-    while(1) {
-        gettimeofday(&end, 0);
-        double elapsed = get_elapsed_time(start, end);
-        if (inst->params.time_limit > 0 && elapsed > inst->params.time_limit) {
-            status = TIME_LIMIT_EXCEEDED;
-            LOG_I("2-opt heuristics time exceeded");
-            break;
+    if (set->count + 1 >= MAX_VISITED_OPTIMA) {
+        // The oldest visits are not tracked, so the memory is just cleared
+        MEMSET(set->keys, 0, set->capacity, uint64_t);
+        set->count = 0;
+    } else if (2 * (set->count + 1) > set->capacity) {
+        uint64_t *old_keys = set->keys;
+        int old_capacity = set->capacity;
+        set->capacity *= 2;
+        set->keys = CALLOC(set->capacity, uint64_t);
+        set->count = 0;
+        for (int h = 0; h < old_capacity; h++) {
+            if (old_keys[h] != 0) { optima_set_put(set, old_keys[h]); }
         }
-        mindelta = 0;
-        for (int i = 0; i < inst->num_nodes - 1; i++) {
-            for (int j = i+1; j < inst->num_nodes; j++) {
-                int a = i;
-                int b = j;
-                int a1 = inst->solution.edges[a].j;
-                int b1 = inst->solution.edges[b].j;
-                if (b == a1 || b1 == a) {
-                    continue;
-                }
-                int edge_idx1 = x_udir_pos(a, b, inst->num_nodes);
-                int edge_idx2 = x_udir_pos(a, a1, inst->num_nodes);
-                int edge_idx3 = x_udir_pos(b, b1, inst->num_nodes);
-                int edge_idx4 = x_udir_pos(a, b1, inst->num_nodes);
-
-                if (skip_edge && 
-                    (check_tenure(&(skip_edge[edge_idx1]), iter, tenure)  || 
-                    check_tenure(&(skip_edge[edge_idx2]), iter, tenure)   || 
-                    check_tenure(&(skip_edge[edge_idx3]), iter, tenure)   || 
-                    check_tenure(&(skip_edge[edge_idx4]), iter, tenure)   
-                    )) {
-                        continue;
-                    }
-                double delta = calc_dist(a, b, inst) + calc_dist(a1, b1, inst) - calc_dist(a, a1, inst) - calc_dist(b, b1, inst);
-                if (delta < mindelta) {
-                    mindelta = delta;
-                    mina = i;
-                    minb = j;
-                }
+        FREE(old_keys);
+    }
+    optima_set_put(set, key);
+    return 0;
+}
+
+////////////////////////////////////////////////////////
+///////////////// NEIGHBOURHOOD ////////////////////////
+////////////////////////////////////////////////////////
+
+// State of a tabu search trajectory. The neighbourhood is 2-opt restricted to the candidate lists: a move
+// adds the edge (a, c) where c is a candidate of a. The best admissible improving move of each node is cached
+// and the nodes with an improving move are kept in a heap ordered by the move value, so after a move only the
+// entries of the nodes touched by it are evaluated again
+typedef struct {
+    instance *inst;
+    local_search *ls;           // The current tour
+    tabu_list *tabu_edges;      // The edges which cannot be added or removed
+    tenure_policy policy;
+    rng_state *rng;
+    int iter;                   // The current iteration. It increases at every kick
+    double cost;                // The cost of the current tour
+    double best_obj;            // The cost of the best tour found. Tabu moves leading below it are allowed (aspiration)
+    uint64_t hash;              // The Zobrist hash of the current tour
+    optima_set *visited;        // The hashes of the local optima visited
+    int *rev_beg;               // The nodes which have node v as candidate are rev_adj[rev_beg[v]] ... rev_adj[rev_beg[v + 1] - 1]
+    int *rev_adj;
+    int *move_b;                // The cached move of node a removes the edges (a, move_b[a]) and (move_c[a], move_d[a])
+    int *move_c;
+    int *move_d;
+    heap *moves;                // The nodes with an improving cached move, keyed by the cost change of the move
+    int *stamps;                // The last update in which each node has been evaluated
+    int stamp;
+    int *kicks;                 // The endpoints of the kick of iteration i are kicks[4 * (i % kicks_size)] ... kicks[4 * (i % kicks_size) + 3]
+    int kicks_size;
+    int last_released;          // The last iteration whose tabu edges have been released
+} tabu_state;
+
+/**
+ * Checks whether the 2-opt move which removes (a, b), (c, d) and adds (a, c), (b, d) is tabu and does not
+ * satisfy the aspiration criterion
+ */
+static int is_forbidden(const tabu_state *ts, int a, int b, int c, int d, double delta) {
+    int tenure = ts->policy.current_tenure;
+    if (!tabu_list_contains(ts->tabu_edges, a, b, ts->iter, tenure) &&
+        !tabu_list_contains(ts->tabu_edges, c, d, ts->iter, tenure) &&
+        !tabu_list_contains(ts->tabu_edges, a, c, ts->iter, tenure) &&
+        !tabu_list_contains(ts->tabu_edges, b, d, ts->iter, tenure)) {
+        return 0;
+    }
+    return ts->cost + delta >= ts->best_obj - EPS;
+}
+
+/**
+ * Computes the best admissible improving move which adds an edge between node a and one of its candidates
+ * and updates its entry in the cache
+ */
+static void evaluate_node(tabu_state *ts, int a) {
+    local_search *ls = ts->ls;
+    int k = ls->cand->k;
+    const int *neighbours = &(ls->cand->neighbours[(long) a * k]);
+    double best_delta = -EPS;
+    int best_c = -1;
+    int b_dir[2] = {ls_succ(ls, a), ls_pred(ls, a)};
+    double d_ab[2] = {ls_edge_cost(ls, a, b_dir[0]), ls_edge_cost(ls, a, b_dir[1])};
+    double d_max = d_ab[0] > d_ab[1] ? d_ab[0] : d_ab[1];
+    for (int h = 0; h < k; h++) {
+        int c = neighbours[h];
+        double d_ac = ls_edge_cost(ls, a, c);
+        if (d_ac >= d_max) continue; // The new edge must be shorter than the removed one
+        for (int dir = 0; dir < 2; dir++) {
+            int b = b_dir[dir];
+            if (d_ac >= d_ab[dir]) continue;
+            int d = dir == 0 ? ls_succ(ls, c) : ls_pred(ls, c);
+            if (c == b || d == a) continue;
+            double delta = d_ac + ls_edge_cost(ls, b, d) - d_ab[dir] - ls_edge_cost(ls, c, d);
+            if (delta < best_delta && !is_forbidden(ts, a, b, c, d, delta)) {
+                best_delta = delta;
+                best_c = c;
+                ts->move_b[a] = b;
+                ts->move_d[a] = d;
             }
         }
-        if (mindelta >= 0) {
-            break;
-        }
-        int mina1 = inst->solution.edges[mina].j;
-        int minb1 = inst->solution.edges[minb].j; 
-        inst->solution.edges[mina].j = minb;
-        inst->solution.edges[mina1].j = minb1;
-        reverse_path(inst, minb, mina1, prev);
-        
-    }
-    inst->solution.obj_best = 0.0;
-    for (int i = 0; i < inst->num_nodes; i++) {
-        edge e = inst->solution.edges[i];
-        inst->solution.obj_best += calc_dist(e.i, e.j, inst);
     }
-    if(stored_prev) {
-        memcpy(stored_prev, prev, sizeof(int) * inst->num_nodes);
+    ts->move_c[a] = best_c;
+    if (best_c >= 0) {
+        heap_push(ts->moves, a, best_delta);
+    } else {
+        heap_remove(ts->moves, a);
     }
-    FREE(prev);
-    return status;
+}
+
+static void touch_once(tabu_state *ts, int v) {
+    if (ts->stamps[v] == ts->stamp) return;
+    ts->stamps[v] = ts->stamp;
+    evaluate_node(ts, v);
 }
 
 /**
- * The effective implementation of tabu search. It implements a tabu list for edges rather than nodes.
- * 
- * @param inst The instance pointer of the problem
- * @param policy_ptr The callback function pointer used for changing the algorithm's current tenure.
+ * Evaluates again the nodes whose cached move can involve node v, i.e. v and the nodes which have v as candidate.
+ * Each node is evaluated at most once in the same update
+ */
+static void touch_node(tabu_state *ts, int v) {
+    touch_once(ts, v);
+    for (int h = ts->rev_beg[v]; h < ts->rev_beg[v + 1]; h++) { touch_once(ts, ts->rev_adj[h]); }
+}
+
+/**
+ * Evaluates again the moves between the path of positions from ... from + len - 1 and the rest of the tour,
+ * i.e. the nodes of the path with a candidate outside it and the nodes outside with a candidate in the path.
+ * The moves inside each side do not change when the path is reversed
+ */
+static void touch_reversed_path(tabu_state *ts, int from, int len) {
+    const local_search *ls = ts->ls;
+    int n = ls->num_nodes;
+    int k = ls->cand->k;
+    for (int h = 0, p = from; h < len; h++, p = (p + 1 == n ? 0 : p + 1)) {
+        int v = ls->tour[p];
+        const int *neighbours = &(ls->cand->neighbours[(long) v * k]);
+        for (int c = 0; c < k; c++) {
+            if ((ls->pos[neighbours[c]] - from + n) % n >= len) {
+                touch_once(ts, v);
+                break;
+            }
+        }
+        for (int r = ts->rev_beg[v]; r < ts->rev_beg[v + 1]; r++) {
+            int u = ts->rev_adj[r];
+            if ((ls->pos[u] - from + n) % n >= len) { touch_once(ts, u); }
+        }
+    }
+}
+
+/**
+ * Applies the 2-opt move which removes (a, b), (c, d) and adds (a, c), (b, d), then updates the cached moves
+ * touched by it. Besides the endpoints, the move reverses the path b ... c with respect to the rest of the tour,
+ * which changes which moves between the two sides are feasible
  * 
- * @returns The status code 0 when no errors occur.
+ * @returns The cost change of the tour
  */
-static int tabu(instance *inst, void (*policy_ptr)(tenure_policy*, int)) {
-    int status = 0;
+static double apply_move(tabu_state *ts, int a, int b, int c, int d) {
+    local_search *ls = ts->ls;
+    int n = ls->num_nodes;
+    double delta = ls_2opt_move(ls, a, b, c, d);
+    ts->hash ^= edge_zobrist(a, b, n) ^ edge_zobrist(c, d, n) ^ edge_zobrist(a, c, n) ^ edge_zobrist(b, d, n);
+    ts->stamp++;
+    // Now the path c ... b lies between a and d
+    int from = ls->pos[c], to = ls->pos[b];
+    if (ls_succ(ls, a) != c) {
+        from = ls->pos[b];
+        to = ls->pos[c];
+    }
+    int len = (to - from + n) % n + 1;
+    if (2 * len > n) {
+        from = (to + 1) % n;
+        len = n - len;
+    }
+    touch_reversed_path(ts, from, len);
+    touch_node(ts, a);
+    touch_node(ts, b);
+    touch_node(ts, c);
+    touch_node(ts, d);
+    return delta;
+}
+
+static void evaluate_all(tabu_state *ts) {
+    for (int v = 0; v < ts->ls->num_nodes; v++) { evaluate_node(ts, v); }
+}
+
+/**
+ * Checks whether the cached move of node a can still be applied: its edges must be in the tour with the
+ * same orientation and it must be admissible. Reversals far from the node can change the orientation
+ */
+static int cached_move_valid(const tabu_state *ts, int a, double delta) {
+    const local_search *ls = ts->ls;
+    int b = ts->move_b[a], c = ts->move_c[a], d = ts->move_d[a];
+    int same_dir = (ls_succ(ls, a) == b && ls_succ(ls, c) == d) || (ls_pred(ls, a) == b && ls_pred(ls, c) == d);
+    return same_dir && !is_forbidden(ts, a, b, c, d, delta);
+}
 
-    //Start counting time from now
-    struct timeval start, end;
-    gettimeofday(&start, 0);
+/**
+ * Touches the endpoints of the edges which left the tabu list since the last call, so the moves which use them
+ * become available again
+ */
+static void release_expired(tabu_state *ts) {
+    int last = ts->iter - ts->policy.current_tenure - 1; // The last iteration whose edges are no longer tabu
+    if (ts->last_released < last - ts->kicks_size) { ts->last_released = last - ts->kicks_size; } // Older kicks are forgotten
+    ts->stamp++;
+    for (int i = ts->last_released + 1; i <= last; i++) {
+        if (i < 1) continue;
+        for (int h = 0; h < 4; h++) { touch_node(ts, ts->kicks[4 * (i % ts->kicks_size) + h]); }
+    }
+    if (last > ts->last_released) { ts->last_released = last; }
+}
 
-    int *tabu_edge = CALLOC(inst->num_columns, int);
-    int *prev = CALLOC(inst->num_nodes, int);
+/**
+ * Applies the best admissible improving moves until no node has one. The best move is taken from the heap
+ * and the entries of the nodes touched by it are updated
+ */
+static void descent(tabu_state *ts) {
+    int a;
+    double delta;
+    while ((a = heap_pop(ts->moves, &delta)) != -1) {
+        if (!cached_move_valid(ts, a, delta)) {
+            evaluate_node(ts, a);
+            continue;
+        }
+        ts->cost += apply_move(ts, a, ts->move_b[a], ts->move_c[a], ts->move_d[a]);
+    }
+}
 
-    //Compute initial solution
-    //int grasp_time_lim = inst->params.time_limit / 5;
-    status = HEU_2opt_greedy_iter(inst);
-    if (status) {
-        LOG_E("An error occurred in HEU_2opt_greedy_iter");
+/**
+ * Builds the reverse candidate lists: for each node the nodes which have it as candidate
+ */
+static void build_reverse_candidates(tabu_state *ts) {
+    const candidate_list *cand = ts->ls->cand;
+    int n = ts->ls->num_nodes;
+    int k = cand->k;
+    ts->rev_beg = CALLOC((n + 1), int);
+    ts->rev_adj = MALLOC(((long) n * k), int);
+    for (long h = 0; h < (long) n * k; h++) { ts->rev_beg[cand->neighbours[h] + 1]++; }
+    for (int v = 0; v < n; v++) { ts->rev_beg[v + 1] += ts->rev_beg[v]; }
+    int *fill = MALLOC(n, int);
+    memcpy(fill, ts->rev_beg, n * sizeof(int));
+    for (int v = 0; v < n; v++) {
+        for (int h = 0; h < k; h++) {
+            int c = cand->neighbours[(long) v * k + h];
+            ts->rev_adj[fill[c]++] = v;
+        }
     }
-    if (inst->params.verbose >= 5) {
-        LOG_I("Completed initialization");
+    FREE(fill);
+}
+
+////////////////////////////////////////////////////////
+///////////////// TRAJECTORIES /////////////////////////
+////////////////////////////////////////////////////////
+
+// Data shared by the trajectories running in parallel
+typedef struct {
+    instance *inst;
+    void (*policy_ptr)(tenure_policy*, int); // The tenure policy of the trajectories
+    double time_limit;
+    struct timeval start;
+    const edge *init_tour;      // The tour from which all the trajectories start
+    pthread_mutex_t mutex;      // Protects the incumbent solution
+    elite_pool *elite;          // The good local optima found by the trajectories
+    int *best_tour;             // The best tour found by all the trajectories, in visiting order
+    double best_obj;
+} tabu_shared;
+
+// A tabu search trajectory running on its own thread
+typedef struct {
+    tabu_shared *shared;
+    int id;
+    rng_state rng;
+    int iterations;
+    int restarts;               // The number of restarts from the elite pool
+    int repetitions;            // The number of local optima visited again
+    int status;
+} tabu_thread;
+
+/**
+ * Initializes the state of a trajectory which starts from the given tour
+ */
+static void tabu_state_init(tabu_state *ts, instance *inst, rng_state *rng, const edge *tour) {
+    ts->inst = inst;
+    ts->rng = rng;
+    ts->policy.min_tenure = ceil(inst->num_nodes * MIN_TENURE_RATE);// Ceil in order to have 1 for small instances. // Hyper parameter
+    ts->policy.max_tenure = round(inst->num_nodes * MAX_TENURE_RATE); // Hyper parameter
+    if (ts->policy.min_tenure == ts->policy.max_tenure) {
+        ts->policy.max_tenure += 2;
+    } else if (ts->policy.max_tenure < ts->policy.min_tenure) {
+        int tmp = ts->policy.min_tenure;
+        ts->policy.min_tenure = ts->policy.max_tenure;
+        ts->policy.max_tenure = tmp;
     }
+    ts->policy.current_tenure = ts->policy.min_tenure;
+    ts->policy.incr_tenure = 0;
+    ts->policy.rng = rng;
+    ts->policy.repeated = 0;
+    ts->policy.last_change = 0;
+
+    ts->ls = ls_create(inst);
+    if (ls_load_edges(ts->ls, tour)) {LOG_E("The initial solution is not a tour");}
+    ts->hash = tour_zobrist(ts->ls->tour, ts->ls->num_nodes);
+    ts->visited = optima_set_create();
+    ts->tabu_edges = tabu_list_create(inst->num_nodes, ts->policy.max_tenure);
+    ts->iter = 1;
+    ts->cost = ls_tour_cost(ts->ls);
+    ts->best_obj = DBL_MAX;
+    build_reverse_candidates(ts);
+    ts->move_b = MALLOC(inst->num_nodes, int);
+    ts->move_c = MALLOC(inst->num_nodes, int);
+    ts->move_d = MALLOC(inst->num_nodes, int);
+    ts->moves = heap_create(inst->num_nodes);
+    ts->stamps = CALLOC(inst->num_nodes, int);
+    ts->stamp = 0;
+    ts->kicks_size = ts->policy.max_tenure + 2;
+    ts->kicks = MALLOC((4 * ts->kicks_size), int);
+    ts->last_released = 0;
+    evaluate_all(ts);
+}
 
-    plot_solution(inst);
+static void tabu_state_free(tabu_state *ts) {
+    heap_free(ts->moves);
+    FREE(ts->move_b);
+    FREE(ts->move_c);
+    FREE(ts->move_d);
+    FREE(ts->stamps);
+    FREE(ts->kicks);
+    FREE(ts->rev_beg);
+    FREE(ts->rev_adj);
+    tabu_list_free(ts->tabu_edges);
+    optima_set_free(ts->visited);
+    ls_free(ts->ls);
+}
 
-    double best_obj = DBL_MAX;
-    edge *best_sol = CALLOC(inst->num_nodes, edge);
-    tenure_policy tenure_policy;
-    tenure_policy.min_tenure = ceil(inst->num_nodes * MIN_TENURE_RATE);// Ceil in order to have 1 for small instances. // Hyper parameter
-    tenure_policy.max_tenure = round(inst->num_nodes * MAX_TENURE_RATE); // Hyper parameter
-    if (tenure_policy.min_tenure == tenure_policy.max_tenure) {
-        tenure_policy.max_tenure += 2;
-    } else if (tenure_policy.max_tenure < tenure_policy.min_tenure) {
-        int tmp = tenure_policy.min_tenure;
-        tenure_policy.min_tenure = tenure_policy.max_tenure;
-        tenure_policy.max_tenure = tmp;
+/**
+ * Moves the trajectory to another tour and empties its tabu list
+ */
+static void tabu_restart(tabu_state *ts, const int *tour) {
+    ls_load(ts->ls, tour);
+    ts->hash = tour_zobrist(ts->ls->tour, ts->ls->num_nodes);
+    ts->cost = ls_tour_cost(ts->ls);
+    ts->best_obj = ts->cost;
+    tabu_list_free(ts->tabu_edges);
+    ts->tabu_edges = tabu_list_create(ts->ls->num_nodes, ts->policy.max_tenure);
+    ts->last_released = ts->iter;
+    evaluate_all(ts);
+}
+
+/**
+ * Exchanges two random edges which are not tabu and makes them tabu. It moves the trajectory away from
+ * the current local optimum. On small instances every pair of edges can be tabu, so after
+ * KICK_MAX_ATTEMPTS * n attempts the last pair is exchanged anyway. The tour must have at least 4 nodes
+ */
+static void kick(tabu_state *ts, void (*policy_ptr)(tenure_policy*, int)) {
+    int n = ts->ls->num_nodes;
+    // Seeking the pair edges to change. We don't want to choose two adiacent edges to swap
+    int a, b, a1, b1;
+    int attempts = KICK_MAX_ATTEMPTS * n;
+    while (1) {
+        a = rand_choice(0, n, ts->rng);
+        // b is at least 2 positions after a and 2 positions before it, so the edges are not contiguous
+        b = ts->ls->tour[(ts->ls->pos[a] + rand_choice(2, n - 1, ts->rng)) % n];
+
+        a1 = ls_succ(ts->ls, a);
+        b1 = ls_succ(ts->ls, b);
+
+        if (--attempts <= 0) break;
+
+        // Checking whether the edges are in the tabu list. If they're in the tabu list, those edges should not be touched
+        // If the edges are not in tabu list, we can exit from this loop and swap these edges
+        if (!tabu_list_contains(ts->tabu_edges, a, a1, ts->iter, ts->policy.current_tenure) && 
+            !tabu_list_contains(ts->tabu_edges, b, b1, ts->iter, ts->policy.current_tenure) &&
+            !tabu_list_contains(ts->tabu_edges, a, b, ts->iter, ts->policy.current_tenure) && 
+            !tabu_list_contains(ts->tabu_edges, a1, b1, ts->iter, ts->policy.current_tenure)) {
+            break;
+        }
     }
+    (*policy_ptr)(&(ts->policy), ts->iter);
+
+    //Put the 2 edges in the tabu list
+    tabu_list_add(ts->tabu_edges, a, a1, ts->iter);
+    tabu_list_add(ts->tabu_edges, b, b1, ts->iter);
+    int *kick = &(ts->kicks[4 * (ts->iter % ts->kicks_size)]);
+    kick[0] = a; kick[1] = a1; kick[2] = b; kick[3] = b1;
 
-    tenure_policy.current_tenure = tenure_policy.min_tenure;
-    tenure_policy.incr_tenure = 0;
+    ts->iter++;
+    ts->cost += apply_move(ts, a, a1, b, b1);
+}
+
+/**
+ * Offers a tour to the elite pool and updates the incumbent solution
+ */
+static void share_tour(tabu_shared *shared, const int *tour, double cost) {
+    int n = shared->inst->num_nodes;
+    pthread_mutex_lock(&(shared->mutex));
+    if (cost < shared->best_obj - EPS) {
+        shared->best_obj = cost;
+        memcpy(shared->best_tour, tour, n * sizeof(int));
+        if (shared->inst->params.verbose >= 3) {
+            LOG_I("Updated incumbent: %f", cost);
+        }
+    }
+    pthread_mutex_unlock(&(shared->mutex));
+    elite_add(shared->elite, tour, cost);
+}
+
+/**
+ * The effective implementation of tabu search. It implements a tabu list for edges rather than nodes.
+ * Every iteration descends to a local optimum with the candidate 2-opt neighbourhood and then exchanges two
+ * random edges which are not tabu. The removed edges become tabu. When the trajectory does not improve its
+ * best tour for STAGNATION_ITER iterations it relinks its tour to a tour of the elite pool and restarts from the
+ * best intermediate tour.
+ * 
+ * @param arg The tabu_thread pointer of the trajectory
+ */
+static void* tabu_trajectory(void *arg) {
+    tabu_thread *thread = (tabu_thread*) arg;
+    tabu_shared *shared = thread->shared;
+    instance *inst = shared->inst;
+    struct timeval end;
+
+    tabu_state ts;
+    tabu_state_init(&ts, inst, &(thread->rng), shared->init_tour);
+    int *tour = MALLOC(inst->num_nodes, int);
+    int *guide = MALLOC(inst->num_nodes, int);
+    int last_improvement = ts.iter;
+    thread->status = 0;
 
-    int iter = 1;
     while (1) {
         //Check elapsed time
         gettimeofday(&end, 0);
-        double elapsed = get_elapsed_time(start, end);
-        if (inst->params.time_limit > 0 && elapsed > inst->params.time_limit) {
-            status = TIME_LIMIT_EXCEEDED;
-            if (inst->params.verbose >= 3) {LOG_I("Tabu Search time exceeded");}
+        double elapsed = get_elapsed_time(shared->start, end);
+        if (elapsed > shared->time_limit) {
+            thread->status = TIME_LIMIT_EXCEEDED;
+            if (inst->params.verbose >= 3 && thread->id == 0) {LOG_I("Tabu Search time exceeded");}
             break;
         }
 
+        // Tabu moves far from the last kick can become admissible by aspiration when the incumbent changes,
+        // so all the entries are evaluated again from time to time
+        if (ts.iter % REFRESH_INTERVAL == 0) { evaluate_all(&ts); }
+
         //Optimize
-        status = alg_2opt_tabu(inst, tabu_edge, prev, iter, tenure_policy.current_tenure);
+        release_expired(&ts);
+        descent(&ts);
+        ts.policy.repeated = optima_set_visit(ts.visited, ts.hash);
+        thread->repetitions += ts.policy.repeated;
 
         //Update the best solution
-        if (inst->solution.obj_best < best_obj) {
-            best_obj = inst->solution.obj_best;
-            memcpy(best_sol, inst->solution.edges, inst->num_nodes * sizeof(edge));
-            if (inst->params.verbose >= 3) {
-                LOG_I("Updated incumbent: %f", best_obj);
-            }
-            if (!inst->params.perf_prof) { plot_solution(inst); }
-            
+        if (ts.cost < ts.best_obj - EPS) {
+            ts.cost = ls_tour_cost(ts.ls); // Avoids the drift of the accumulated cost changes
+            ts.best_obj = ts.cost;
+            last_improvement = ts.iter;
+            ls_store(ts.ls, tour);
+            share_tour(shared, tour, ts.cost);
         }
-        if (inst->params.verbose >= 4) {
-            LOG_I("Current sol: %0.0f     Incumbent: %0.0f", inst->solution.obj_best, best_obj);
-        }   
-        
-        if (status) {
-            LOG_I("2-opt move returned status %d", status);
-            break;
+        if (inst->params.verbose >= 4 && thread->id == 0) {
+            LOG_I("Current sol: %0.0f     Incumbent: %0.0f", ts.cost, ts.best_obj);
+        }
+
+        // A stagnating trajectory walks toward an elite tour, possibly found by another trajectory, and continues
+        // from the best improved intermediate tour. The elite tour itself is used when the two tours are too close
+        if (ts.iter - last_improvement >= STAGNATION_ITER && elite_pick(shared->elite, guide, NULL, ts.rng)) {
+            double cost = path_relinking(ts.ls, guide, RELINK_CHECKPOINTS, tour);
+            if (cost < DBL_MAX) { share_tour(shared, tour, cost); }
+            tabu_restart(&ts, cost < DBL_MAX ? tour : guide);
+            last_improvement = ts.iter;
+            thread->restarts++;
+            continue;
         }
+
         // We're in local minimum now. We have to swap two edges and add these two in the tabu list
+        kick(&ts, shared->policy_ptr);
 
-        // Seeking the pair edges to change. We don't want to choose two adiacent edges to swap
-        int a, b, a1, b1;
-        while (1) {
-            a = rand_choice(0, inst->num_nodes);
-            b = rand_choice(0, inst->num_nodes);
+        if (inst->params.verbose >= 5 && thread->id == 0) {
+            LOG_I("Current tenure %d", ts.policy.current_tenure);
+        }
+    }
+    thread->iterations = ts.iter;
 
-            a1 = inst->solution.edges[a].j;
-            b1 = inst->solution.edges[b].j;
+    tabu_state_free(&ts);
+    FREE(tour);
+    FREE(guide);
+    return NULL;
+}
 
-            // Don't want the same node for a and b and don't want contiguous edges
-            if (a == b || a1 == b || b1 == a) {
-                continue;
-            }
+/**
+ * Runs a tabu search trajectory on each thread. The trajectories start from the same greedy tour and use
+ * different random streams. They share an elite pool of tours and the incumbent solution.
+ * 
+ * @param inst The instance pointer of the problem
+ * @param policy_ptr The callback function pointer used for changing the algorithm's current tenure.
+ * 
+ * @returns The status code 0 when no errors occur.
+ */
+static int tabu(instance *inst, void (*policy_ptr)(tenure_policy*, int)) {
+    tabu_shared shared;
+    shared.inst = inst;
+    shared.policy_ptr = policy_ptr;
+    gettimeofday(&(shared.start), 0); //Start counting time from now
+    shared.time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+
+    //Compute initial solution. The descent of the first iteration refines it
+    int status = HEU_initial_tour(inst);
+    if (status) {
+        LOG_E("An error occurred in HEU_initial_tour");
+    }
+    if (inst->params.verbose >= 5) {
+        LOG_I("Completed initialization");
+    }
 
-            // Checking whether the edges are in the tabu list. If they're in the tabu list, those edges should not be touched
-            int edge_idx1 = x_udir_pos(a, a1, inst->num_nodes);
-            int edge_idx2 = x_udir_pos(b, b1, inst->num_nodes);
-            int edge_idx3 = x_udir_pos(a, b, inst->num_nodes);
-            int edge_idx4 = x_udir_pos(a1, b1, inst->num_nodes);
-            /*if (tabu_edge[edge_idx3] || tabu_edge[edge_idx4]) {
-                printf("IN TABU a-b or a1-b1\n");
-            }
-            if (tabu_edge[edge_idx1] || tabu_edge[edge_idx2]) {
-                printf("IN TABU a-a1 or b-b1\n");
-            }*/
-            // If the edges are not in tabu list, we can exit from this loop and swap these edges
-            if (!check_tenure(&(tabu_edge[edge_idx1]), iter, tenure_policy.current_tenure) && 
-                !check_tenure(&(tabu_edge[edge_idx2]), iter, tenure_policy.current_tenure) &&
-                !check_tenure(&(tabu_edge[edge_idx3]), iter, tenure_policy.current_tenure) && 
-                !check_tenure(&(tabu_edge[edge_idx4]), iter, tenure_policy.current_tenure)) {
-                break;
-            }
-        }
-        inst->solution.edges[a].j = b;
-        inst->solution.edges[a1].j = b1;
-        reverse_path(inst, b, a1, prev);
+    plot_solution(inst);
+
+    // A tour with less than 4 nodes has no pair of edges to exchange, and it is the only tour
+    if (inst->num_nodes < 4) {
+        if (inst->params.verbose >= 3) {LOG_I("Tabu search needs at least 4 nodes. The initial tour is kept");}
+        return 0;
+    }
 
-        (*policy_ptr)(&tenure_policy, iter);
+    // The candidate lists are shared by the trajectories, so they are built before starting the threads
+    get_candidate_lists(inst);
+
+    int num_threads = get_num_threads(inst);
+    if (inst->params.verbose >= 3) {LOG_I("Tabu search with %d trajectories", num_threads);}
+    shared.init_tour = inst->solution.edges;
+    pthread_mutex_init(&(shared.mutex), NULL);
+    shared.elite = elite_create(inst->num_nodes, ELITE_SIZE);
+    // The initial tour is the incumbent until a trajectory finds a better one
+    shared.best_tour = MALLOC(inst->num_nodes, int);
+    shared.best_obj = inst->solution.obj_best;
+    for (int i = 0, node = 0; i < inst->num_nodes; i++) {
+        shared.best_tour[i] = node;
+        node = inst->solution.edges[node].j;
+    }
+
+    tabu_thread *trajectories = CALLOC(num_threads, tabu_thread);
+    pthread_t *threads = MALLOC(num_threads, pthread_t);
+    for (int i = 0; i < num_threads; i++) {
+        trajectories[i].shared = &shared;
+        trajectories[i].id = i;
+        rng_seed(&(trajectories[i].rng), inst->params.seed, i + 1); // Stream 0 is used by the main thread
+    }
+    for (int i = 1; i < num_threads; i++) {
+        pthread_create(&(threads[i]), NULL, tabu_trajectory, &(trajectories[i]));
+    }
+    tabu_trajectory(&(trajectories[0])); // The main thread runs the first trajectory
+    for (int i = 1; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
 
-        if (inst->params.verbose >= 5) {
-            LOG_I("Current tenure %d", tenure_policy.current_tenure);
+    if (inst->params.verbose >= 3) {
+        int iterations = 0, restarts = 0, repetitions = 0;
+        for (int i = 0; i < num_threads; i++) {
+            iterations += trajectories[i].iterations;
+            restarts += trajectories[i].restarts;
+            repetitions += trajectories[i].repetitions;
         }
-        //plot_solution(inst);
-        //sleep(1);
-        
-        //Put the 2 edges in the tabu list
-        int edge_idx1 = x_udir_pos(a, a1, inst->num_nodes);
-        int edge_idx2 = x_udir_pos(b, b1, inst->num_nodes);
-        tabu_edge[edge_idx1] = iter;
-        tabu_edge[edge_idx2] = iter;
-        
-        iter++;
-    }
-
-    inst->solution.obj_best = best_obj;
-    memcpy(inst->solution.edges, best_sol, inst->num_nodes * sizeof(edge));
-    FREE(tabu_edge);
-    FREE(prev);
-    FREE(best_sol);
+        LOG_I("Tabu search iterations: %d, restarts from the elite pool: %d, local optima visited again: %d", iterations, restarts, repetitions);
+    }
+    status = trajectories[0].status;
+
+    inst->solution.obj_best = shared.best_obj;
+    for (int i = 0; i < inst->num_nodes; i++) {
+        int node = shared.best_tour[i];
+        inst->solution.edges[node].i = node;
+        inst->solution.edges[node].j = shared.best_tour[(i + 1) % inst->num_nodes];
+    }
+
+    // Free allocations
+    pthread_mutex_destroy(&(shared.mutex));
+    elite_free(shared.elite);
+    FREE(shared.best_tour);
+    FREE(trajectories);
+    FREE(threads);
     return status;
 }
 
@@ -334,3 +826,8 @@ int HEU_Tabu_rand(instance *inst) {
     return tabu(inst, random_policy);
 }
 
+//Wrapper for tabu reactive
+int HEU_Tabu_reactive(instance *inst) {
+    return tabu(inst, reactive_policy);
+}
+
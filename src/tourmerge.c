@@ -0,0 +1,226 @@
+#include "tourmerge.h"
+
+#include "solver.h"
+#include "heuristics.h"
+#include "distutil.h"
+#include "candidates.h"
+#include "elite.h"
+#include "vns.h"
+
+
+//Compares two edge keys for qsort
+static int compare_keys(const void *a, const void *b) {
+    long long key_a = *((const long long*) a);
+    long long key_b = *((const long long*) b);
+    return (key_a > key_b) - (key_a < key_b);
+}
+
+//Runs VNS with different seeds and stores the different tours found in the pool
+static void collect_tours(instance *inst, elite_pool *pool, double time_limit) {
+    int n = inst->num_nodes;
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+
+    // The candidate lists are built on demand, so they are built once here and all the runs share them
+    get_candidate_lists(inst);
+
+    // Each run works on a copy of the instance which shares the problem data and owns its solution
+    instance run_inst = *inst;
+    run_inst.params.perf_prof = 1; // No plots and no files
+    run_inst.params.verbose = inst->params.verbose >= 5 ? 3 : -1;
+    int run_time = (int) (time_limit / TOUR_MERGE_NUM_TOURS);
+    run_inst.params.time_limit = run_time > 1 ? run_time : 1;
+    run_inst.ind = NULL;
+    run_inst.thread_rngs = NULL;
+    run_inst.warm_start = NULL;
+    run_inst.solution.xbest = NULL;
+    run_inst.solution.edges = CALLOC(n, edge);
+    int *tour = MALLOC(n, int);
+
+    for (int run = 0; run < TOUR_MERGE_NUM_TOURS; run++) {
+        gettimeofday(&end, 0);
+        if (run > 0 && get_elapsed_time(start, end) >= time_limit) break;
+
+        run_inst.params.seed = (int) (rng_next(&(inst->rng)) & 0x7FFFFFFF);
+        rng_seed(&(run_inst.rng), run_inst.params.seed, 0);
+        int status = HEU_VNS(&run_inst);
+        if (status && status != TIME_LIMIT_EXCEEDED) {LOG_E("VNS error code %d", status);}
+
+        // Store the tour in visiting order
+        int node = 0;
+        for (int pos = 0; pos < n; pos++) {
+            tour[pos] = node;
+            node = run_inst.solution.edges[node].j;
+        }
+        int added = elite_add(pool, tour, run_inst.solution.obj_best);
+        if (inst->params.verbose >= 4) {
+            LOG_I("VNS run %d: %0.2f%s", run + 1, run_inst.solution.obj_best, added ? "" : " (already found)");
+        }
+    }
+
+    FREE(tour);
+    FREE(run_inst.solution.edges);
+}
+
+//Builds the sparse graph whose edges are the union of the edges of the tours
+static sparse_graph* build_union_graph(int num_nodes, const int *tours, int num_tours) {
+    // Each edge (i, j) with i < j has the key i * num_nodes + j. Sorting the keys removes the repeated edges
+    long num_keys = (long) num_tours * num_nodes;
+    long long *keys = MALLOC(num_keys, long long);
+    long k = 0;
+    for (int t = 0; t < num_tours; t++) {
+        const int *tour = &(tours[(long) t * num_nodes]);
+        for (int pos = 0; pos < num_nodes; pos++) {
+            int i = tour[pos];
+            int j = tour[pos + 1 < num_nodes ? pos + 1 : 0];
+            keys[k++] = i < j ? (long long) i * num_nodes + j : (long long) j * num_nodes + i;
+        }
+    }
+    qsort(keys, num_keys, sizeof(long long), compare_keys);
+
+    sparse_graph *graph = MALLOC(1, sparse_graph);
+    graph->edges = MALLOC(num_keys, edge);
+    graph->num_edges = 0;
+    for (long h = 0; h < num_keys; h++) {
+        if (h > 0 && keys[h] == keys[h - 1]) continue;
+        edge e = {(int) (keys[h] / num_nodes), (int) (keys[h] % num_nodes)};
+        graph->edges[graph->num_edges++] = e;
+    }
+
+    // The adjacency lists of the nodes, one after the other
+    graph->beg = CALLOC((num_nodes + 1), int);
+    for (int c = 0; c < graph->num_edges; c++) {
+        graph->beg[graph->edges[c].i + 1]++;
+        graph->beg[graph->edges[c].j + 1]++;
+    }
+    for (int i = 0; i < num_nodes; i++) {
+        graph->beg[i + 1] += graph->beg[i];
+    }
+    graph->adj = MALLOC((2 * graph->num_edges), int);
+    graph->cols = MALLOC((2 * graph->num_edges), int);
+    int *next = MALLOC(num_nodes, int); // The next free position in the list of each node
+    memcpy(next, graph->beg, num_nodes * sizeof(int));
+    for (int c = 0; c < graph->num_edges; c++) {
+        edge e = graph->edges[c];
+        graph->adj[next[e.i]] = e.j;
+        graph->cols[next[e.i]++] = c;
+        graph->adj[next[e.j]] = e.i;
+        graph->cols[next[e.j]++] = c;
+    }
+
+    FREE(next);
+    FREE(keys);
+    return graph;
+}
+
+//Builds the model of the undirected graph with only the edges of inst->sparse
+static void build_sparse_model(instance *inst, CPXENVptr env, CPXLPptr lp) {
+    sparse_graph *graph = inst->sparse;
+    char xctype = 'B';  // B=binary variable
+    char *names = CALLOC(100, char);
+
+    // The column c is the edge graph->edges[c]
+    for (int c = 0; c < graph->num_edges; c++) {
+        edge e = graph->edges[c];
+        sprintf(names, "x(%d,%d)", e.i+1, e.j+1);
+        double obj = calc_dist(e.i, e.j, inst);
+        double lb = 0.0;
+        double ub = 1.0;
+        int status = CPXnewcols(env, lp, 1, &obj, &lb, &ub, &xctype, &names);
+        if (status) {
+            LOG_E("An error occured inserting a new variable");
+        }
+    }
+
+    // Adding the degree constraints
+    for (int h = 0; h < inst->num_nodes; h++) {
+        double rhs = 2.0;
+        char sense = 'E';
+        sprintf(names, "degree(%d)", h+1);
+        int status = CPXnewrows(env, lp, 1, &rhs, &sense, NULL, &names);
+        if (status) {
+            LOG_E("CPXnewrows() error code %d", status);
+        }
+        for (int p = graph->beg[h]; p < graph->beg[h + 1]; p++) {
+            status = CPXchgcoef(env, lp, h, graph->cols[p], 1.0);
+            if (status) {
+                LOG_E("CPXchgcoef() error code %d", status);
+            }
+        }
+    }
+
+    FREE(names);
+}
+
+int tour_merge_solver(instance *inst, CPXENVptr env, CPXLPptr lp) {
+    int n = inst->num_nodes;
+    double time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+    struct timeval start, end;
+    gettimeofday(&start, 0);    // start counting elapsed time from now
+
+    // Collect the tours to merge
+    if (inst->params.verbose >= 3) {
+        LOG_I("Starting heuristic tours");
+    }
+    elite_pool *pool = elite_create(n, TOUR_MERGE_NUM_TOURS);
+    collect_tours(inst, pool, time_limit * TOUR_MERGE_HEURISTIC_TIME_RATE);
+    int *best_tour = MALLOC(n, int);
+    double best_obj = elite_best(pool, best_tour);
+    if (inst->params.verbose >= 3) {
+        LOG_I("Different tours: %d. Best tour: %0.2f", pool->size, best_obj);
+    }
+
+    // Build the model on the union of the edges of the tours
+    inst->sparse = build_union_graph(n, pool->tours, pool->size);
+    build_sparse_model(inst, env, lp);
+    save_lp(env, lp, inst->name);
+    inst->num_columns = CPXgetnumcols(env, lp);
+    FREE(inst->ind);
+    inst->ind = MALLOC(inst->num_columns, int);
+    for (int k = 0; k < inst->num_columns; k++) {
+        inst->ind[k] = k;
+    }
+    if (inst->params.verbose >= 3) {
+        LOG_I("Columns of the model: %ld (%0.2f per node)", inst->num_columns, (double) inst->num_columns / n);
+    }
+
+    // The best tour is the starting solution
+    double *xh = CALLOC(inst->num_columns, double);
+    for (int pos = 0; pos < n; pos++) {
+        xh[x_udir_col(inst, best_tour[pos], best_tour[pos + 1 < n ? pos + 1 : 0])] = 1.0;
+    }
+    int beg = 0;
+    int level = CPX_MIPSTART_NOCHECK;
+    int status = CPXaddmipstarts(env, lp, 1, inst->num_columns, &beg, inst->ind, xh, &level, NULL);
+    if (status) {
+        LOG_E("CPXaddmipstarts() error code %d", status);
+    }
+
+    status = configure_opt_best_solver(env, lp, inst);
+    if (status) {LOG_E("Configure opt best solver in tour merging error code %d", status);}
+
+    // Solve the model in the remaining time
+    gettimeofday(&end, 0);
+    double time_remain = dmax(time_limit - get_elapsed_time(start, end), 1.0);
+    CPXsetdblparam(env, CPXPARAM_TimeLimit, time_remain);
+    if (inst->params.verbose >= 5) {LOG_I("Time remaining: %0.1f seconds", time_remain);}
+    status = CPXmipopt(env, lp);
+    if (status) {LOG_E("CPXmipopt error code %d", status);}
+
+    // Store the solution. The starting solution is kept if cplex has none
+    inst->solution.xbest = CALLOC(inst->num_columns, double);
+    double objval;
+    if (CPXgetx(env, lp, inst->solution.xbest, 0, inst->num_columns - 1) || CPXgetobjval(env, lp, &objval)) {
+        memcpy(inst->solution.xbest, xh, inst->num_columns * sizeof(double));
+        objval = best_obj;
+    }
+    inst->solution.obj_best = objval;
+    if (inst->params.verbose >= 3) {
+        LOG_I("Merged tour: %0.2f. Best tour: %0.2f", objval, best_obj);
+    }
+
+    elite_free(pool);
+    FREE(best_tour);
+    FREE(xh);
+    return 0;
+}
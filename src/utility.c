@@ -7,8 +7,11 @@
 #include <sys/stat.h>
 #include <math.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "plot.h"
+#include "candidates.h"
+#include "spacecurve.h"
 
 double dmax(double d1, double d2) {
     return d1 > d2 ? d1 : d2;
@@ -29,6 +32,15 @@ int x_udir_pos(int i, int j, int num_nodes) {
     return i * num_nodes + j - ((i + 1) * (i + 2)) / 2;
 }
 
+int x_udir_col(const instance *inst, int i, int j) {
+    const sparse_graph *graph = inst->sparse;
+    if (graph == NULL) return x_udir_pos(i, j, inst->num_nodes);
+    for (int p = graph->beg[i]; p < graph->beg[i + 1]; p++) {
+        if (graph->adj[p] == j) return graph->cols[p];
+    }
+    return -1;
+}
+
 int x_dir_pos(int i, int j, int num_nodes) {
     if (i > num_nodes - 1 || j > num_nodes -1 ) {
         LOG_E("Indexes passed greater than the number of nodes");
@@ -44,6 +56,260 @@ static int check_input_index_validity(int index, int argc, int *need_help) {
     return 0;
 }
 
+int parse_method(const char *method, instance_params *params) {
+    sol_method found = {.name = NULL};
+    int callback_2opt = params->callback_2opt;
+    // Directed graph methods
+    if (strncmp(method, "MTZ", 3) == 0) {
+        found.id = SOLVE_MTZ;
+        found.edge_type = DIR_EDGE;
+        found.name = "MTZ Static";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "MTZL", 4) == 0) {
+        found.id = SOLVE_MTZL;
+        found.edge_type = DIR_EDGE;
+        found.name = "MTZ Lazy";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "MTZI", 4) == 0) {
+        found.id = SOLVE_MTZI;
+        found.edge_type = DIR_EDGE;
+        found.name = "MTZ with SEC of degree 2";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "MTZLI", 5) == 0) {
+        found.id = SOLVE_MTZLI;
+        found.edge_type = DIR_EDGE;
+        found.name = "MTZ lazy with SEC of degree 2";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "MTZ_IND", 5) == 0) {
+        found.id = SOLVE_MTZ_IND;
+        found.edge_type = DIR_EDGE;
+        found.name = "MTZ with indicator constraints";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "GG", 2) == 0) {
+        found.id = SOLVE_GG;
+        found.edge_type = DIR_EDGE;
+        found.name = "GG";
+        found.use_cplex = 1;
+    }
+
+    // Undirected graph methods
+    if (strncmp(method, "LOOP", 4) == 0) {
+        found.id = SOLVE_LOOP;
+        found.edge_type = UDIR_EDGE;
+        found.name = "BENDERS' LOOP";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "CALLBACK", 8) == 0) {
+        found.id = SOLVE_CALLBACK;
+        found.edge_type = UDIR_EDGE;
+        found.name = "INCUBEMENT CALLBACK";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "USER_CUT", 9) == 0) {
+        found.id = SOLVE_UCUT;
+        found.edge_type = UDIR_EDGE;
+        found.name = "USER CUT CALLBACK";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "CALLBACK_2OPT", 14) == 0) {
+        found.id = SOLVE_CALLBACK;
+        found.edge_type = UDIR_EDGE;
+        found.name = "INCUBEMENT CALLBACK WITH 2OPT";
+        found.use_cplex = 1;
+        callback_2opt = 1;
+    }
+    if (strncmp(method, "USER_CUT_2OPT", 13) == 0) {
+        found.id = SOLVE_UCUT;
+        found.edge_type = UDIR_EDGE;
+        found.name = "USER CUT CALLBACK WITH 2OPT";
+        found.use_cplex = 1;
+        callback_2opt = 1;
+    }
+    if (strncmp(method, "HARD_FIX", 8) == 0) {
+        found.id = SOLVE_HARD_FIXING;
+        found.edge_type = UDIR_EDGE;
+        found.name = "HARD FIXING HEURISTIC FIXED PROB";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "HARD_FIX2", 9) == 0) {
+        found.id = SOLVE_HARD_FIXING2;
+        found.edge_type = UDIR_EDGE;
+        found.name = "HARD FIXING HEURISTIC VARIABLE PROB";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "SOFT_FIX", 8) == 0) {
+        found.id = SOLVE_SOFT_FIXING;
+        found.edge_type = UDIR_EDGE;
+        found.name = "SOFT FIXING HEURISTIC";
+        found.use_cplex = 1;
+    }
+    if (strncmp(method, "GREEDY", 6) == 0) {
+        found.id = SOLVE_GREEDY;
+        found.edge_type = UDIR_EDGE;
+        found.name = "GREEDY HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "GREEDY_ITER", 11) == 0) {
+        found.id = SOLVE_GREEDY_ITER;
+        found.edge_type = UDIR_EDGE;
+        found.name = "GREEDY ITERATIVE HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "EXTR_MIL", 6) == 0) {
+        found.id = SOLVE_EXTR_MIL;
+        found.edge_type = UDIR_EDGE;
+        found.name = "EXTRA MILEAGE HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "GRASP", 5) == 0) {
+        found.id = SOLVE_GRASP;
+        found.edge_type = UDIR_EDGE;
+        found.name = "GRASP HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "GRASP_ITER", 10) == 0) {
+        found.id = SOLVE_GRASP_ITER;
+        found.edge_type = UDIR_EDGE;
+        found.name = "GRASP ITERATIVE HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_GRASP", 9) == 0) {
+        found.id = SOLVE_2OPT_GRASP;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH GRASP INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_GRASP_ITER", 15) == 0) {
+        found.id = SOLVE_2OPT_GRASP_ITER;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH ITERATIVE GRASP INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_GREEDY", 11) == 0) {
+        found.id = SOLVE_2OPT_GREEDY;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH GREEDY INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_GREEDY_ITER", 16) == 0) {
+        found.id = SOLVE_2OPT_GREEDY_ITER;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH ITERATIVE GREEDY INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_EXTR_MIL", 13) == 0) {
+        found.id = SOLVE_2OPT_EXTR_MIL;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH EXTRA MILEAGE INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "SAVINGS", 7) == 0) {
+        found.id = SOLVE_SAVINGS;
+        found.edge_type = UDIR_EDGE;
+        found.name = "SAVINGS HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_SAVINGS", 12) == 0) {
+        found.id = SOLVE_2OPT_SAVINGS;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH SAVINGS INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "CHRISTOFIDES", 12) == 0) {
+        found.id = SOLVE_CHRISTOFIDES;
+        found.edge_type = UDIR_EDGE;
+        found.name = "CHRISTOFIDES-LIKE HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "2OPT_CHRISTOFIDES", 17) == 0) {
+        found.id = SOLVE_2OPT_CHRISTOFIDES;
+        found.edge_type = UDIR_EDGE;
+        found.name = "2-OPT HEURISTIC WITH CHRISTOFIDES-LIKE INITIALIZATION";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "VNS", 3) == 0) {
+        found.id = SOLVE_VNS;
+        found.edge_type = UDIR_EDGE;
+        found.name = "VNS META-HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "TABU_STEP", 9) == 0) {
+        found.id = SOLVE_TABU_STEP;
+        found.edge_type = UDIR_EDGE;
+        found.name = "TABU SEARCH META-HEURISTIC WITH STEP POLICY";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "TABU_LIN", 8) == 0) {
+        found.id = SOLVE_TABU_LIN;
+        found.edge_type = UDIR_EDGE;
+        found.name = "TABU SEARCH META-HEURISTIC WITH LINEAR POLICY";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "TABU_RAND", 9) == 0) {
+        found.id = SOLVE_TABU_RAND;
+        found.edge_type = UDIR_EDGE;
+        found.name = "TABU SEARCH META-HEURISTIC WITH RANDOM POLICY";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "TABU_REACTIVE", 13) == 0) {
+        found.id = SOLVE_TABU_REACTIVE;
+        found.edge_type = UDIR_EDGE;
+        found.name = "TABU SEARCH META-HEURISTIC WITH REACTIVE POLICY";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "GENETIC", 7) == 0) {
+        found.id = SOLVE_GENETIC;
+        found.edge_type = UDIR_EDGE;
+        found.name = "GENETIC ALGORITHM META-HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "SIMULATED_ANNEALING", 19) == 0) {
+        found.id = SOLVE_SIMULATED_ANNEALING;
+        found.edge_type = UDIR_EDGE;
+        found.name = "SIMULATED ANNEALING META-HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "ACO", 3) == 0) {
+        found.id = SOLVE_ACO;
+        found.edge_type = UDIR_EDGE;
+        found.name = "ANT COLONY OPTIMIZATION META-HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "ALNS", 4) == 0) {
+        found.id = SOLVE_ALNS;
+        found.edge_type = UDIR_EDGE;
+        found.name = "ADAPTIVE LARGE NEIGHBOURHOOD SEARCH META-HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "GLS", 3) == 0) {
+        found.id = SOLVE_GLS;
+        found.edge_type = UDIR_EDGE;
+        found.name = "GUIDED LOCAL SEARCH META-HEURISTIC";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "PORTFOLIO", 9) == 0) {
+        found.id = SOLVE_PORTFOLIO;
+        found.edge_type = UDIR_EDGE;
+        found.name = "PORTFOLIO OF HEURISTICS";
+        found.use_cplex = 0;
+    }
+    if (strncmp(method, "TOUR_MERGE", 10) == 0) {
+        found.id = SOLVE_TOUR_MERGE;
+        found.edge_type = UDIR_EDGE;
+        found.name = "TOUR MERGING";
+        found.use_cplex = 1;
+    }
+    if (found.name == NULL) return 0;
+    params->method = found;
+    params->callback_2opt = callback_2opt;
+    return 1;
+}
+
 void parse_comand_line(int argc, const char *argv[], instance *inst) {
 
     if (argc <= 1) {
@@ -62,11 +328,25 @@ void parse_comand_line(int argc, const char *argv[], instance *inst) {
     inst->params.seed = time(NULL); // We want to specify the random seed as the current time in order to have a real randomness when user doesn't explicitly choose the seed
     inst->params.perf_prof = 0;
     inst->params.callback_2opt = 0;
+    inst->params.grasp_rand = DEFAULT_GRASP_RAND;
+    inst->params.grasp_rcl = DEFAULT_GRASP_RCL;
+    inst->params.grasp_alpha = -1; // Alpha mode disabled by default
+    inst->params.grasp_time_lim = DEFAULT_GRASP_ITER_TIME_LIM;
+    inst->params.num_candidates = DEFAULT_NUM_CANDIDATES;
+    inst->params.renumber = 1;
+    inst->params.deterministic = 0;
+    inst->params.sync_rounds = DEFAULT_SYNC_ROUNDS;
+    inst->params.portfolio = NULL;
+    inst->params.target_obj = -1;
     inst->name = NULL;
     inst->comment = NULL;
     inst->nodes = NULL;
     inst->ind = NULL;
-    inst->thread_seeds = NULL;
+    inst->thread_rngs = NULL;
+    inst->candidates = NULL;
+    inst->original_ids = NULL;
+    inst->warm_start = NULL;
+    inst->sparse = NULL;
     inst->solution.edges = NULL;
     inst->solution.xbest = NULL;
     int need_help = 0;
@@ -94,187 +374,7 @@ void parse_comand_line(int argc, const char *argv[], instance *inst) {
         }
         if (strcmp("-method", argv[i]) == 0) {
             if (check_input_index_validity(i, argc, &need_help)) continue;
-            const char* method = argv[++i];
-            
-            // Directed graph methods
-            if (strncmp(method, "MTZ", 3) == 0) {
-                inst->params.method.id = SOLVE_MTZ;
-                inst->params.method.edge_type = DIR_EDGE;
-                inst->params.method.name = "MTZ Static";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "MTZL", 4) == 0) {
-                inst->params.method.id = SOLVE_MTZL;
-                inst->params.method.edge_type = DIR_EDGE;
-                inst->params.method.name = "MTZ Lazy";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "MTZI", 4) == 0) {
-                inst->params.method.id = SOLVE_MTZI;
-                inst->params.method.edge_type = DIR_EDGE;
-                inst->params.method.name = "MTZ with SEC of degree 2";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "MTZLI", 5) == 0) {
-                inst->params.method.id = SOLVE_MTZLI;
-                inst->params.method.edge_type = DIR_EDGE;
-                inst->params.method.name = "MTZ lazy with SEC of degree 2";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "MTZ_IND", 5) == 0) {
-                inst->params.method.id = SOLVE_MTZ_IND;
-                inst->params.method.edge_type = DIR_EDGE;
-                inst->params.method.name = "MTZ with indicator constraints";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "GG", 2) == 0) {
-                inst->params.method.id = SOLVE_GG;
-                inst->params.method.edge_type = DIR_EDGE;
-                inst->params.method.name = "GG";
-                inst->params.method.use_cplex = 1;
-            }
-
-            // Undirected graph methods
-            if (strncmp(method, "LOOP", 4) == 0) {
-                inst->params.method.id = SOLVE_LOOP;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "BENDERS' LOOP";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "CALLBACK", 8) == 0) {
-                inst->params.method.id = SOLVE_CALLBACK;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "INCUBEMENT CALLBACK";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "USER_CUT", 9) == 0) {
-                inst->params.method.id = SOLVE_UCUT;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "USER CUT CALLBACK";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "CALLBACK_2OPT", 14) == 0) {
-                inst->params.method.id = SOLVE_CALLBACK;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "INCUBEMENT CALLBACK WITH 2OPT";
-                inst->params.method.use_cplex = 1;
-                inst->params.callback_2opt = 1;
-            }
-            if (strncmp(method, "USER_CUT_2OPT", 13) == 0) {
-                inst->params.method.id = SOLVE_UCUT;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "USER CUT CALLBACK WITH 2OPT";
-                inst->params.method.use_cplex = 1;
-                inst->params.callback_2opt = 1;
-            }
-            if (strncmp(method, "HARD_FIX", 8) == 0) {
-                inst->params.method.id = SOLVE_HARD_FIXING;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "HARD FIXING HEURISTIC FIXED PROB";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "HARD_FIX2", 9) == 0) {
-                inst->params.method.id = SOLVE_HARD_FIXING2;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "HARD FIXING HEURISTIC VARIABLE PROB";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "SOFT_FIX", 8) == 0) {
-                inst->params.method.id = SOLVE_SOFT_FIXING;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "SOFT FIXING HEURISTIC";
-                inst->params.method.use_cplex = 1;
-            }
-            if (strncmp(method, "GREEDY", 6) == 0) {
-                inst->params.method.id = SOLVE_GREEDY;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "GREEDY HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "GREEDY_ITER", 11) == 0) {
-                inst->params.method.id = SOLVE_GREEDY_ITER;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "GREEDY ITERATIVE HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "EXTR_MIL", 6) == 0) {
-                inst->params.method.id = SOLVE_EXTR_MIL;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "EXTRA MILEAGE HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "GRASP", 5) == 0) {
-                inst->params.method.id = SOLVE_GRASP;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "GRASP HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "GRASP_ITER", 10) == 0) {
-                inst->params.method.id = SOLVE_GRASP_ITER;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "GRASP ITERATIVE HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "2OPT_GRASP", 9) == 0) {
-                inst->params.method.id = SOLVE_2OPT_GRASP;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "2-OPT HEURISTIC WITH GRASP INITIALIZATION";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "2OPT_GRASP_ITER", 15) == 0) {
-                inst->params.method.id = SOLVE_2OPT_GRASP_ITER;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "2-OPT HEURISTIC WITH ITERATIVE GRASP INITIALIZATION";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "2OPT_GREEDY", 11) == 0) {
-                inst->params.method.id = SOLVE_2OPT_GREEDY;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "2-OPT HEURISTIC WITH GREEDY INITIALIZATION";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "2OPT_GREEDY_ITER", 16) == 0) {
-                inst->params.method.id = SOLVE_2OPT_GREEDY_ITER;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "2-OPT HEURISTIC WITH ITERATIVE GREEDY INITIALIZATION";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "2OPT_EXTR_MIL", 13) == 0) {
-                inst->params.method.id = SOLVE_2OPT_EXTR_MIL;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "2-OPT HEURISTIC WITH EXTRA MILEAGE INITIALIZATION";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "VNS", 3) == 0) {
-                inst->params.method.id = SOLVE_VNS;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "VNS META-HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "TABU_STEP", 9) == 0) {
-                inst->params.method.id = SOLVE_TABU_STEP;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "TABU SEARCH META-HEURISTIC WITH STEP POLICY";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "TABU_LIN", 8) == 0) {
-                inst->params.method.id = SOLVE_TABU_LIN;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "TABU SEARCH META-HEURISTIC WITH LINEAR POLICY";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "TABU_RAND", 9) == 0) {
-                inst->params.method.id = SOLVE_TABU_RAND;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "TABU SEARCH META-HEURISTIC WITH RANDOM POLICY";
-                inst->params.method.use_cplex = 0;
-            }
-            if (strncmp(method, "GENETIC", 7) == 0) {
-                inst->params.method.id = SOLVE_GENETIC;
-                inst->params.method.edge_type = UDIR_EDGE;
-                inst->params.method.name = "GENETIC ALGORITHM META-HEURISTIC";
-                inst->params.method.use_cplex = 0;
-            }
+            parse_method(argv[++i], &(inst->params));
             continue;
         }
         if (strcmp("-seed", argv[i]) == 0) {
@@ -282,9 +382,51 @@ void parse_comand_line(int argc, const char *argv[], instance *inst) {
             inst->params.seed = atoi(argv[++i]);
             continue;
         }
+        if (strcmp("-grasp_rand", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.grasp_rand = atof(argv[++i]);
+            continue;
+        }
+        if (strcmp("-grasp_rcl", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.grasp_rcl = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp("-grasp_alpha", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.grasp_alpha = atof(argv[++i]);
+            continue;
+        }
+        if (strcmp("-grasp_time", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.grasp_time_lim = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp("-candidates", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.num_candidates = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp("-portfolio", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.portfolio = (char *) argv[++i];
+            continue;
+        }
+        if (strcmp("-target", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.target_obj = atof(argv[++i]);
+            continue;
+        }
         if (strcmp("--fcost", argv[i]) == 0) { inst->params.integer_cost = 0; continue; }
         if (strcmp("--methods", argv[i]) == 0) {show_methods = 1; continue;}
         if (strcmp("--perfprof", argv[i]) == 0) {inst->params.perf_prof = 1; continue;}
+        if (strcmp("--no_renumber", argv[i]) == 0) {inst->params.renumber = 0; continue;}
+        if (strcmp("--deterministic", argv[i]) == 0) {inst->params.deterministic = 1; continue;}
+        if (strcmp("-rounds", argv[i]) == 0) {
+            if (check_input_index_validity(i, argc, &need_help)) continue;
+            inst->params.sync_rounds = atoi(argv[++i]);
+            continue;
+        }
         if (strcmp("--v", argv[i]) == 0 || strcmp("--version", argv[i]) == 0) { printf("Version %s\n", VERSION); exit(0);} //Version of the software
         if (strcmp("--help", argv[i]) == 0) { need_help = 1; continue; } // For comands documentation
         need_help = 1;
@@ -305,6 +447,7 @@ void parse_comand_line(int argc, const char *argv[], instance *inst) {
         printf("HARD_FIX           Hard fixing heuristic method with fixed prob\n");
         printf("HARD_FIX2          Hard fixing heuristic method with variable prob\n");
         printf("SOFT_FIX           Soft fixing heuristic method\n");
+        printf("TOUR_MERGE         Cplex on the edges of several VNS tours\n");
         printf("GREEDY             Greedy algorithm method\n");
         printf("GREEDY_ITER        Iterative Greedy algorithm method\n");
         printf("EXTR_MILE          Extra mileage method\n");
@@ -315,11 +458,21 @@ void parse_comand_line(int argc, const char *argv[], instance *inst) {
         printf("2OPT_GREEDY        2-OPT with Greedy initialization\n");
         printf("2OPT_GREEDY_ITER   2-OPT with iterative Greedy initialization\n");
         printf("2OPT_EXTR_MIL      2-OPT with extra mileage initialization\n");
+        printf("SAVINGS            Clarke-Wright savings method\n");
+        printf("2OPT_SAVINGS       2-OPT with savings initialization\n");
+        printf("CHRISTOFIDES       Christofides-like method with greedy matching\n");
+        printf("2OPT_CHRISTOFIDES  2-OPT with Christofides-like initialization\n");
         printf("VNS                VNS method\n");
         printf("TABU_STEP          TABU Search method with step policy\n");
         printf("TABU_LIN           TABU Search method with linear policy\n");
         printf("TABU_RAND          TABU Search method with random policy\n");
+        printf("TABU_REACTIVE      TABU Search method with reactive policy\n");
         printf("GENETIC            GENETIC Algorithm\n");
+        printf("SIMULATED_ANNEALING Simulated annealing with random candidate moves\n");
+        printf("ACO                MAX-MIN ant system with parallel ants\n");
+        printf("ALNS               Adaptive large neighbourhood search with destroy and repair operators\n");
+        printf("GLS                Guided local search with edge penalties\n");
+        printf("PORTFOLIO          Races the methods given with -portfolio on a thread pool\n");
         exit(0);
     }
 
@@ -331,7 +484,17 @@ void parse_comand_line(int argc, const char *argv[], instance *inst) {
         printf("-verbose <level>          The verbosity level of the debugging printing\n");
         printf("-method <type>            The method used to solve the problem. Use \"--methods\" to see the list of available methods\n");
         printf("-seed <seed>              The seed for random generation\n");
+        printf("-grasp_rand <prob>        The probability of choosing the nearest node in GRASP (default %0.2f)\n", DEFAULT_GRASP_RAND);
+        printf("-grasp_rcl <size>         The size of GRASP's restricted candidate list (default %d)\n", DEFAULT_GRASP_RCL);
+        printf("-grasp_alpha <alpha>      Uses the alpha threshold on GRASP's candidate list instead of grasp_rand\n");
+        printf("-grasp_time <time>        The time limit in seconds of iterative GRASP initialization (default %d)\n", DEFAULT_GRASP_ITER_TIME_LIM);
+        printf("-candidates <k>           The number of nearest nodes in the candidate list of each node (default %d)\n", DEFAULT_NUM_CANDIDATES);
+        printf("-portfolio <methods>      The comma separated methods raced by PORTFOLIO (e.g. 2OPT_GRASP_ITER,VNS,TABU_REACTIVE,GENETIC)\n");
+        printf("-target <cost>            PORTFOLIO stops when it finds a tour with this cost or lower\n");
         printf("--fcost                   Whether you want float costs in the problem\n");
+        printf("--no_renumber             Keeps the file order of the nodes in heuristic methods\n");
+        printf("--deterministic           Parallel VNS synchronizes its threads at fixed points for reproducible runs. It stops after -rounds rounds instead of the time limit\n");
+        printf("-rounds <num rounds>      The number of synchronization rounds of the deterministic mode (default %d)\n", DEFAULT_SYNC_ROUNDS);
         printf("--v, --version            Software's current version\n");
         exit(0);
     }
@@ -343,11 +506,25 @@ void free_instance(instance *inst) {
     FREE(inst->comment);
     FREE(inst->nodes);
     FREE(inst->ind);
-    FREE(inst->thread_seeds);
+    FREE(inst->thread_rngs);
+    free_candidate_lists(inst->candidates);
+    inst->candidates = NULL;
+    FREE(inst->original_ids);
+    free_sparse_graph(inst->sparse);
+    inst->sparse = NULL;
     FREE(inst->solution.edges);
     FREE(inst->solution.xbest);
 }
 
+void free_sparse_graph(sparse_graph *graph) {
+    if (graph == NULL) return;
+    FREE(graph->edges);
+    FREE(graph->beg);
+    FREE(graph->adj);
+    FREE(graph->cols);
+    FREE(graph);
+}
+
 void parse_instance(instance *inst) {
     if (inst->params.file_path == NULL) { LOG_E("You didn't pass any file!"); }
 
@@ -543,7 +720,7 @@ void export_tour(instance *inst) {
     edge e = inst->solution.edges[0]; // Starting node
     
     for (int i = 0; i < inst->num_nodes; i++) { // The tour is composed by the number of nodes
-        fprintf(tour, "%d\n", e.i + 1);
+        fprintf(tour, "%d\n", original_id(inst, e.i) + 1);
         e = inst->solution.edges[e.j];
     }
     
@@ -558,6 +735,28 @@ int count_components(instance *inst, double* xstar, int* successors, int* comp)
     return count_components_adv(inst, xstar, successors, comp, NULL, NULL);
 }
 
+/**
+ * Finds a node not yet in a component which is linked to node by an edge of the solution
+ *
+ * @returns The node found. -1 if there is none
+ */
+static int find_successor(instance *inst, double *xstar, int node, int *comp) {
+    const sparse_graph *graph = inst->sparse;
+    if (graph != NULL) {
+        // Only the edges of the model can be in the solution
+        for (int p = graph->beg[node]; p < graph->beg[node + 1]; p++) {
+            int j = graph->adj[p];
+            if (comp[j] < 0 && fabs(xstar[graph->cols[p]]) >= EPS) return j;
+        }
+        return -1;
+    }
+    for (int j = 0; j < inst->num_nodes; j++) {
+        if (node == j || comp[j] >= 0) continue;
+        if (fabs(xstar[x_udir_pos(node, j, inst->num_nodes)]) >= EPS) return j;
+    }
+    return -1;
+}
+
 int count_components_adv(instance *inst, double* xstar, int* successors, int* comp, edge* close_cycle_edges, int* num_closed_cycles) {
 
     int num_comp = 0;
@@ -573,15 +772,12 @@ int count_components_adv(instance *inst, double* xstar, int* successors, int* co
 		while ( !visit_comp ) { // go and visit the current component
 			comp[current_node] = num_comp;
 			visit_comp = 1; // We set the flag visited to true until we find the successor
-			for ( int j = 0; j < inst->num_nodes; j++ ) {
-                if (current_node == j || comp[j] >= 0) continue;
-				if (fabs(xstar[x_udir_pos(current_node,j,inst->num_nodes)]) >= EPS ) {
-					successors[current_node] = j;
-					current_node = j;
-					visit_comp = 0;
-                    comp_members++;
-					break;
-				}
+			int next = find_successor(inst, xstar, current_node, comp);
+			if (next >= 0) {
+				successors[current_node] = next;
+				current_node = next;
+				visit_comp = 0;
+				comp_members++;
 			}
 		}	
 		successors[current_node] = i;  // last arc to close the cycle
@@ -678,7 +874,9 @@ int prepare_SEC(instance *inst, int tour, int *comp, char *sense, int *indexes,
 
         for (int j = i+1; j < inst->num_nodes; j++) {
             if (comp[j] != tour) continue;
-            indexes[nnz] = x_udir_pos(i, j, inst->num_nodes);
+            int col = x_udir_col(inst, i, j);
+            if (col < 0) continue; // The edge is not in the model
+            indexes[nnz] = col;
             values[nnz] = 1.0;
             nnz++;
         }
@@ -739,7 +937,10 @@ void copy_instance(instance *dst, instance *src) {
         dst->solution.edges = MALLOC(src->num_nodes, edge);
         memcpy(dst->solution.edges, src->solution.edges, sizeof(edge) * src->num_nodes);
     }
-    dst->thread_seeds = NULL;
+    dst->thread_rngs = NULL;
+    dst->candidates = NULL;
+    dst->original_ids = NULL;
+    dst->sparse = NULL;
 }
 
 /**
@@ -747,8 +948,15 @@ void copy_instance(instance *dst, instance *src) {
  * 
  * @param from The left bound 
  * @param to The right bound
+ * @param rng The random generator used to draw the number
  * @returns Random integer between [from, to)
  */
-int rand_choice(int from, int to) {
-    return from + ((int) (URAND() * (to - from)));
-}
\ No newline at end of file
+int rand_choice(int from, int to, rng_state *rng) {
+    return from + ((int) (URAND(rng) * (to - from)));
+}
+
+int get_num_threads(const instance *inst) {
+    if (inst->params.num_threads > 0) return inst->params.num_threads;
+    long num_procs = sysconf(_SC_NPROCESSORS_ONLN);
+    return num_procs > 0 ? (int) num_procs : 1;
+}
@@ -2,168 +2,363 @@
 
 #include "heuristics.h"
 #include "distutil.h"
+#include "localsearch.h"
 
 #include <float.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 
 
-//Function that change randomly some edges in the current solution
-int kick(instance *inst){
-    int status = 0;
+////////////////////////////////////////////////////////
+///////////////// HYPERPARAMETERS //////////////////////
+////////////////////////////////////////////////////////
+#define MAX_KICK_STRENGTH 5 // The maximum number of double-bridges applied by a kick. The strength grows by one after each failed kick and it resets to 1 after an improvement
+#define LOCAL_KICK_RATE 0.9 // The probability that a double-bridge is segment-local instead of using three random edges of the whole tour
+#define LOCAL_KICK_LENGTH 50 // The maximum number of positions spanned by a segment-local double-bridge
+#define SYNC_INTERVAL 1000 // The number of iterations of each thread between two exchanges with the incumbent solution
 
-    //From list of successor to Tour
-    int* tour = CALLOC(inst->num_nodes, int);
-    int node=0;
-    int idx=0;
-    while(idx<inst->num_nodes){
-        tour[idx]=node;
-        idx+=1;
-        node=inst->solution.edges[node].j;
-    }
 
-    //Remove 3 random edges and reconnect them
-    int idx1=rand_choice(0,inst->num_nodes);
-    int idx2=idx1;
-    int idx3=idx1;
-    while(idx2==idx1 || abs(idx1-idx2)<=1){    // no same node and not successor or predecessor idx1
-        idx2=rand_choice(0,inst->num_nodes);
-    }
-    while(idx3==idx1 || idx3==idx2 || abs(idx1-idx3)<=1 || abs(idx2-idx3)<=1){
-        idx3=rand_choice(0,inst->num_nodes);
-    }
-    //put them in order
-    if(idx1>idx2){
-        int tmp=idx1;
-        idx1=idx2;
-        idx2=tmp;
+//Double-bridge: removes the edges a-b, c-d, e-f where b, d, f are the successors of a, c, e (in this order along the tour)
+//and reconnects them as a-d, e-b, c-f, i.e. swaps the paths b...c and d...e without reversing them.
+//The change is done on the local search's tour with three reversals, so the endpoints enter its queue
+//and the change can be undone. Returns the cost change of the tour
+static double double_bridge(local_search *ls, int a, int c, int e){
+    int b=ls_succ(ls, a);
+    int d=ls_succ(ls, c);
+    int f=ls_succ(ls, e);
+
+    double delta = ls_2opt_move(ls, a, b, e, f);    // a e...d c...b f
+    delta += ls_2opt_move(ls, a, e, d, c);          // a d...e c...b f
+    delta += ls_2opt_move(ls, e, c, b, f);          // a d...e b...c f
+    return delta;
+}
+
+//Double-bridge on three random edges of the whole tour. The edges are drawn by construction at least two positions
+//apart along the tour, so the draw always ends. Tours with less than 8 nodes are not changed
+static double random_double_bridge(local_search *ls, rng_state *rng){
+    int n = ls->num_nodes;
+    if (n < 8) return 0;
+
+    //Offsets of the second and third edge from the first one: 2 <= off2, off2 + 2 <= off3 and off3 + 2 <= n
+    int u = rand_choice(0, n - 5, rng);
+    int v = rand_choice(0, n - 5, rng);
+    if (u > v) {
+        int tmp = u;
+        u = v;
+        v = tmp;
     }
-    if(idx1>idx3){
-        int tmp=idx1;
-        idx1=idx3;
-        idx3=tmp;
-    }   //now the smallest element is in idx1
-    if(idx2>idx3){
-        int tmp=idx2;
-        idx2=idx3;
-        idx3=tmp;
+    int off2 = 2 + u;
+    int off3 = 4 + v;
+    int pos = rand_choice(0, n, rng);
+    int a = ls->tour[pos];
+    int c = ls->tour[(pos + off2) % n];
+    int e = ls->tour[(pos + off3) % n];
+    return double_bridge(ls, a, c, e);
+}
+
+//Segment-local double-bridge: the three edges are within LOCAL_KICK_LENGTH positions from a random node,
+//so the new edges are not too long and the local search repairs the tour quickly
+static double local_double_bridge(local_search *ls, rng_state *rng){
+    int n = ls->num_nodes;
+    int len = LOCAL_KICK_LENGTH < n - 1 ? LOCAL_KICK_LENGTH : n - 1;
+    if (len < 5) return random_double_bridge(ls, rng);
+
+    //Offsets of the second and third edge from the first one: 2 <= off2 and off2 + 2 <= off3 < len
+    int off2 = rand_choice(2, len - 2, rng);
+    int off3 = rand_choice(off2 + 2, len, rng);
+    int pos = rand_choice(0, n, rng);
+    int a = ls->tour[pos];
+    int c = ls->tour[(pos + off2) % n];
+    int e = ls->tour[(pos + off3) % n];
+    return double_bridge(ls, a, c, e);
+}
+
+//Function that change randomly some edges in the current solution: applies strength double-bridges, which are
+//segment-local with probability LOCAL_KICK_RATE. Returns the cost change of the tour
+static double kick(local_search *ls, int strength, rng_state *rng){
+    double delta = 0;
+    for (int h = 0; h < strength; h++) {
+        if (URAND(rng) < LOCAL_KICK_RATE) {
+            delta += local_double_bridge(ls, rng);
+        } else {
+            delta += random_double_bridge(ls, rng);
+        }
     }
+    return delta;
+}
+
+
+// Data shared by the threads
+typedef struct {
+    instance *inst;
+    double time_limit;
+    struct timeval start;
+    int num_threads;
+    pthread_mutex_t mutex;      // Protects the incumbent solution and the barrier
+    pthread_cond_t cond;        // Used by the barrier of the deterministic mode
+    int waiting;                // The number of threads waiting at the barrier
+    int generation;             // The number of times the barrier has been passed
+    edge *best_sol;             // The incumbent solution
+    double best_obj;
+    atomic_int version;         // It increases every time the incumbent changes, so the threads check it without locking
+    local_search **searches;    // The local search of each thread. Used to collect the best tour in deterministic mode
+    double *round_obj;          // The best cost of each thread at the last synchronization point (deterministic mode)
+    int stop;                   // Whether the threads stop at the current synchronization point (deterministic mode)
+    int rounds;                 // The number of synchronization rounds done (deterministic mode)
+} vns_shared;
+
+// A thread running its own kick and re-optimize loop
+typedef struct {
+    vns_shared *shared;
+    int id;
+    rng_state rng;
+    local_search *ls;           // The current tour, which is also the best tour of the thread
+    double best_obj;
+    int k;                      // The strength of the next kick
+    int improved;               // Whether the thread improved its tour since the last synchronization
+    int seen_version;           // The version of the incumbent seen at the last synchronization
+    int iterations;
+    int adoptions;              // The number of times the thread continued from the incumbent of another thread
+    int status;
+} vns_thread;
 
-    //LOG_D("%d %d %d",idx1,idx2,idx3);
-
-    int a=tour[idx1];
-    int b=tour[idx1+1];
-    int c=tour[idx2];
-    int d=tour[idx2+1];
-    int e=tour[idx3];
-    int f=tour[idx3+1];
-    inst->solution.edges[a].j =d;   //new successor of a is d
-    inst->solution.edges[e].j =b;   //new successor of e is b
-    inst->solution.edges[c].j =f;   //new successor of c is f
-
-    //From list of successor to Tour (AGAIN TO COMPUTE THE COST)
-    node=0;
-    idx=0;
-    while(idx<inst->num_nodes){
-        tour[idx]=node;
-        idx+=1;
-        node=inst->solution.edges[node].j;
+/**
+ * Waits until all the threads reach the barrier
+ */
+static void barrier_wait(vns_shared *shared) {
+    pthread_mutex_lock(&(shared->mutex));
+    int generation = shared->generation;
+    if (++(shared->waiting) == shared->num_threads) {
+        shared->waiting = 0;
+        shared->generation++;
+        pthread_cond_broadcast(&(shared->cond));
+    } else {
+        while (generation == shared->generation) {
+            pthread_cond_wait(&(shared->cond), &(shared->mutex));
+        }
     }
+    pthread_mutex_unlock(&(shared->mutex));
+}
 
-    //Remove 4 random eges and reconnect them
-    //TODO...
+/**
+ * One VNS iteration: kicks the tour, re-optimizes it around the kicked endpoints and keeps it only if it is better
+ */
+static void vns_iteration(vns_thread *thread) {
+    local_search *ls = thread->ls;
+    instance *inst = thread->shared->inst;
 
-    
+    //The current solution is the best seen so far
+    //Modify current solution to a random point in the neighboorhood. The changes are logged from here
+    int mark = ls_mark(ls);
+    double cost = thread->best_obj + kick(ls, thread->k, &(thread->rng));
 
-    //Compute new tour cost
-    int prev_node = tour[0];
-    double tour_costs = 0;
-    for (int i = 1; i < inst->num_nodes; i++) {
-        int node = tour[i];
-        tour_costs += calc_dist(prev_node, node, inst);
-        prev_node = node;
+    //Optimize only around the kicked endpoints, which are the only nodes in the queue
+    cost += ls_optimize(ls);
+    if (inst->params.verbose >= 4 && thread->id == 0) {LOG_I("Current: %0.0f (k = %d)", cost, thread->k);}
+
+    //If new solution is better than the best, update the best solution
+    if (cost < thread->best_obj - EPS) {
+        thread->best_obj = cost;
+        thread->improved = 1;
+        ls_commit(ls);
+        thread->k = 1;
+    } else {
+        //restore best solution undoing the moves done after the mark
+        ls_undo(ls, mark);
+        //move to the next neighbourhood, with a stronger kick
+        thread->k = thread->k < MAX_KICK_STRENGTH ? thread->k + 1 : 1;
     }
-    tour_costs += calc_dist(prev_node, tour[0], inst);
-    inst->solution.obj_best=tour_costs;
-
-    //From tour to list of successor
-    for (int i = 0; i < inst->num_nodes - 1; i++) {
-        int index = tour[i];
-        inst->solution.edges[index].i = tour[i];
-        inst->solution.edges[index].j = tour[i + 1];
+    thread->iterations++;
+}
+
+/**
+ * Exchanges the best tours with the incumbent: the thread publishes its tour when it is better than the incumbent,
+ * and continues from the incumbent when it is better than its tour. The lock is taken only when the thread improved
+ * or the version of the incumbent changed
+ */
+static void synchronize(vns_thread *thread) {
+    vns_shared *shared = thread->shared;
+    if (!thread->improved && atomic_load(&(shared->version)) == thread->seen_version) return;
+    pthread_mutex_lock(&(shared->mutex));
+    if (thread->best_obj < shared->best_obj - EPS) {
+        shared->best_obj = thread->best_obj;
+        ls_store_edges(thread->ls, shared->best_sol);
+        atomic_fetch_add(&(shared->version), 1);
+        if (shared->inst->params.verbose >= 3) {LOG_I("Updated incumbent: %0.0f", shared->best_obj);}
+    } else if (shared->best_obj < thread->best_obj - EPS) {
+        ls_load_edges(thread->ls, shared->best_sol);
+        thread->best_obj = shared->best_obj;
+        thread->k = 1;
+        thread->adoptions++;
     }
-    int index = tour[inst->num_nodes - 1];
-    inst->solution.edges[index].i = tour[inst->num_nodes - 1];
-    inst->solution.edges[index].j = tour[0];
+    thread->seen_version = atomic_load(&(shared->version));
+    thread->improved = 0;
+    pthread_mutex_unlock(&(shared->mutex));
+}
 
-    FREE(tour);
-    return status;
+/**
+ * Synchronization point of the deterministic mode. All the threads wait for each other, then the best tour
+ * (the first thread wins the ties) becomes the incumbent and the worse threads continue from it.
+ * The search stops after params.sync_rounds rounds and the time is never checked, so the result depends
+ * only on the seed, the number of threads and the number of rounds, not on the speed of the machine
+ * 
+ * @returns 1 when the last round is done and the threads must stop, 0 otherwise
+ */
+static int synchronize_deterministic(vns_thread *thread) {
+    vns_shared *shared = thread->shared;
+    shared->round_obj[thread->id] = thread->best_obj;
+    barrier_wait(shared);
+    if (thread->id == 0) {
+        int winner = 0;
+        for (int i = 1; i < shared->num_threads; i++) {
+            if (shared->round_obj[i] < shared->round_obj[winner] - EPS) { winner = i; }
+        }
+        if (shared->round_obj[winner] < shared->best_obj - EPS) {
+            shared->best_obj = shared->round_obj[winner];
+            ls_store_edges(shared->searches[winner], shared->best_sol);
+            if (shared->inst->params.verbose >= 3) {LOG_I("Updated incumbent: %0.0f", shared->best_obj);}
+        }
+        shared->rounds++;
+        shared->stop = shared->rounds >= shared->inst->params.sync_rounds;
+    }
+    barrier_wait(shared);
+    if (shared->best_obj < thread->best_obj - EPS) {
+        ls_load_edges(thread->ls, shared->best_sol);
+        thread->best_obj = shared->best_obj;
+        thread->k = 1;
+        thread->adoptions++;
+    }
+    thread->improved = 0;
+    return shared->stop;
 }
 
+/**
+ * The loop of a thread: SYNC_INTERVAL iterations between two synchronizations
+ * 
+ * @param arg The vns_thread pointer
+ */
+static void* vns_search(void *arg) {
+    vns_thread *thread = (vns_thread*) arg;
+    vns_shared *shared = thread->shared;
+    struct timeval end;
+    thread->status = 0;
+
+    ///while there is time left
+    while (1) {
+        int stop = 0;
+        for (int it = 0; it < SYNC_INTERVAL && !stop; it++) {
+            //Check elapsed time. The deterministic mode counts the synchronization rounds instead
+            if (!shared->inst->params.deterministic) {
+                gettimeofday(&end, 0);
+                stop = get_elapsed_time(shared->start, end) > shared->time_limit;
+                if (stop) break;
+            }
+            vns_iteration(thread);
+        }
+        if (shared->inst->params.deterministic) {
+            stop = synchronize_deterministic(thread);
+        } else {
+            synchronize(thread);
+        }
+        if (stop) {
+            thread->status = shared->inst->params.deterministic ? 0 : TIME_LIMIT_EXCEEDED;
+            break;
+        }
+    }
+    return NULL;
+}
 
 int HEU_VNS(instance *inst){
-    int status = 0;
+    vns_shared shared;
+    shared.inst = inst;
 
     //Set time limit
     if (inst->params.time_limit <= 0 && inst->params.verbose >= 3) {LOG_I("Default time lim %d setted.", DEFAULT_TIME_LIM);}
-    int time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
+    shared.time_limit = inst->params.time_limit > 0 ? inst->params.time_limit : DEFAULT_TIME_LIM;
     
     //Start counting time from now
-    struct timeval start, end;
-    gettimeofday(&start, 0);
-
-    //Compute initial solution
-    //status=greedy(inst, 0);
-    status=HEU_2opt_greedy_iter(inst);
-    
-    double best_obj=inst->solution.obj_best;  //best solution cost
-    edge *best_sol = CALLOC(inst->num_nodes, edge);
-    memcpy(best_sol, inst->solution.edges, inst->num_nodes * sizeof(edge));
+    gettimeofday(&(shared.start), 0);
 
-    if (inst->params.verbose >= 3) {LOG_I("Initial solution: %0.0f", best_obj);}
+    //Compute initial solution and optimize it with the local search from all the nodes.
+    //It also builds the candidate lists shared by the threads
+    int status=HEU_initial_tour(inst);
+    if (status) {LOG_E("An error occurred in HEU_initial_tour");}
+    local_search *ls = ls_create(inst);
+    if (ls_load_edges(ls, inst->solution.edges)) {LOG_E("The initial solution is not a tour");}
+    ls_queue_all(ls);
+    ls_optimize(ls);
+    shared.best_sol = MALLOC(inst->num_nodes, edge);
+    ls_store_edges(ls, shared.best_sol);
+    shared.best_obj = ls_tour_cost(ls);   //best solution cost
+    ls_free(ls);
 
-    int k=1;
+    if (inst->params.verbose >= 3) {LOG_I("Initial solution: %0.0f", shared.best_obj);}
 
-    ///while there is time left
-    while(1){
-        //Check elapsed time
-        gettimeofday(&end, 0);
-        double elapsed = get_elapsed_time(start, end);
-        if (elapsed > time_limit) {
-            status = TIME_LIMIT_EXCEEDED;
-            break;
-        }
-
-        //The current solution is the best seen so far
-        //Modify current solution to a random point in the neighboorhood
-        kick(inst);
-        //plot_solution(inst);
-
-        //Optimize with 2OPT
-        //inst.params.time_limit = 5;
-        status=alg_2opt(inst);
-        if (inst->params.verbose >= 4) {LOG_I("Current: %0.0f", inst->solution.obj_best);}
+    // Each thread kicks and re-optimizes its own copy of the tour
+    int num_threads = get_num_threads(inst);
+    shared.num_threads = num_threads;
+    if (inst->params.verbose >= 3) {LOG_I("VNS with %d threads%s", num_threads, inst->params.deterministic ? " in deterministic mode" : "");}
+    pthread_mutex_init(&(shared.mutex), NULL);
+    pthread_cond_init(&(shared.cond), NULL);
+    shared.waiting = 0;
+    shared.generation = 0;
+    atomic_init(&(shared.version), 0);
+    shared.searches = MALLOC(num_threads, local_search*);
+    shared.round_obj = MALLOC(num_threads, double);
+    shared.stop = 0;
+    shared.rounds = 0;
 
+    vns_thread *vns_threads = CALLOC(num_threads, vns_thread);
+    pthread_t *threads = MALLOC(num_threads, pthread_t);
+    for (int i = 0; i < num_threads; i++) {
+        vns_threads[i].shared = &shared;
+        vns_threads[i].id = i;
+        rng_seed(&(vns_threads[i].rng), inst->params.seed, i + 1); // Stream 0 is used by the main thread
+        vns_threads[i].ls = ls_create(inst);
+        ls_load_edges(vns_threads[i].ls, shared.best_sol);
+        vns_threads[i].best_obj = shared.best_obj;
+        vns_threads[i].k = 1;
+        shared.searches[i] = vns_threads[i].ls;
+    }
+    for (int i = 1; i < num_threads; i++) {
+        pthread_create(&(threads[i]), NULL, vns_search, &(vns_threads[i]));
+    }
+    vns_search(&(vns_threads[0])); // The main thread runs the first search
+    for (int i = 1; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    // The last improvements of the threads which did not reach a synchronization point
+    for (int i = 0; i < num_threads; i++) {
+        if (!inst->params.deterministic) { synchronize(&(vns_threads[i])); }
+    }
 
-        //If new solution is better than the best, update the best solution
-        if (inst->solution.obj_best < best_obj) {
-            best_obj = inst->solution.obj_best;
-            memcpy(best_sol, inst->solution.edges, inst->num_nodes * sizeof(edge));
-            
-            if (inst->params.verbose >= 3) {LOG_I("Updated incumbent: %0.0f", best_obj);}
-            plot_solution(inst);
+    if (inst->params.verbose >= 3) {
+        int iterations = 0, adoptions = 0;
+        for (int i = 0; i < num_threads; i++) {
+            iterations += vns_threads[i].iterations;
+            adoptions += vns_threads[i].adoptions;
         }
-
-        //restore best solution
-        inst->solution.obj_best = best_obj;
-        memcpy(inst->solution.edges, best_sol, inst->num_nodes * sizeof(edge));
-
+        LOG_I("VNS iterations: %d, restarts from the incumbent: %d", iterations, adoptions);
     }
+    status = vns_threads[0].status;
 
     //restore best solution
-    inst->solution.obj_best = best_obj;
-    memcpy(inst->solution.edges, best_sol, inst->num_nodes * sizeof(edge));
+    memcpy(inst->solution.edges, shared.best_sol, inst->num_nodes * sizeof(edge));
+    inst->solution.obj_best = 0;
+    for (int i = 0; i < inst->num_nodes; i++) {
+        inst->solution.obj_best += calc_dist(i, shared.best_sol[i].j, inst);
+    }
 
-    FREE(best_sol);
+    // Free allocations
+    for (int i = 0; i < num_threads; i++) { ls_free(vns_threads[i].ls); }
+    pthread_mutex_destroy(&(shared.mutex));
+    pthread_cond_destroy(&(shared.cond));
+    FREE(shared.best_sol);
+    FREE(shared.searches);
+    FREE(shared.round_obj);
+    FREE(vns_threads);
+    FREE(threads);
 
     return status;
-}
\ No newline at end of file
+}
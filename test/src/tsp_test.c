@@ -9,7 +9,11 @@ int main(int argc, const char *argv[]) {
     parse_instance(&inst);
     print_instance(inst);
 
-    TSP_opt(&inst);
+    if (inst.params.method.use_cplex) {
+        TSP_opt(&inst);
+    } else {
+        TSP_heuc(&inst);
+    }
     
     free_instance(&inst);
   return 0;